@@ -1,5 +1,13 @@
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 #include <CppUnitTest.h>
 
 #include "CppFactory.hpp"
@@ -27,10 +35,209 @@ namespace CppFactoryUnitTests
 		DataArgs(int value, int value2) : Value(value), Value2(value2) {}
 	};
 
+	struct Tracked
+	{
+	public:
+		static std::atomic<int> Destroyed;
+		static std::thread::id DestroyedOn;
+
+		~Tracked()
+		{
+			DestroyedOn = std::this_thread::get_id();
+			++Destroyed;
+		}
+	};
+
+	std::atomic<int> Tracked::Destroyed(0);
+	std::thread::id Tracked::DestroyedOn;
+
+	std::mutex TeardownMutex;
+	std::vector<int> TeardownOrder;
+
+	struct Connection
+	{
+	public:
+		~Connection()
+		{
+			std::lock_guard<std::mutex> lock(TeardownMutex);
+			TeardownOrder.push_back(2);
+		}
+	};
+
+	struct Service
+	{
+	public:
+		~Service()
+		{
+			std::lock_guard<std::mutex> lock(TeardownMutex);
+			TeardownOrder.push_back(1);
+		}
+	};
+
+	struct Engine
+	{
+	};
+
+	struct Car
+	{
+	public:
+		std::shared_ptr<Engine> CarEngine;
+		std::shared_ptr<Data> CarData;
+
+		Car(std::shared_ptr<Engine> engine, const std::shared_ptr<Data>& data) : CarEngine(engine), CarData(data) {}
+	};
+
+	struct Wheel
+	{
+	};
+
+	struct Bike
+	{
+	public:
+		std::shared_ptr<Wheel> Front;
+		std::shared_ptr<Wheel> Back;
+		std::shared_ptr<Engine> BikeEngine;
+
+		Bike(std::shared_ptr<Wheel> front, std::shared_ptr<Wheel> back, std::shared_ptr<Engine> engine) : Front(front), Back(back), BikeEngine(engine) {}
+	};
+
+	struct Shape
+	{
+	public:
+		virtual ~Shape() {}
+		virtual int Sides() const = 0;
+	};
+
+	struct Square final : public Shape
+	{
+	public:
+		int Sides() const override { return 4; }
+	};
+
+	struct Triangle final : public Shape
+	{
+	public:
+		int Sides() const override { return 3; }
+	};
+
+	struct Drawing
+	{
+	public:
+		std::shared_ptr<Shape> DrawingShape;
+
+		Drawing(std::shared_ptr<Shape> shape) : DrawingShape(shape) {}
+	};
+
+	struct AddOne
+	{
+		template <class TNext>
+		std::shared_ptr<Data> operator()(const TNext& next) const
+		{
+			auto data = next();
+			data->Value += 1;
+			return data;
+		}
+	};
+
+	struct Double
+	{
+		template <class TNext>
+		std::shared_ptr<Data> operator()(const TNext& next) const
+		{
+			auto data = next();
+			data->Value *= 2;
+			return data;
+		}
+	};
+
+	struct Chicken;
+
+	struct Egg
+	{
+	public:
+		Egg(std::shared_ptr<Chicken>) {}
+	};
+
+	struct Chicken
+	{
+	public:
+		Chicken(std::shared_ptr<Egg>) {}
+	};
+}
+
+namespace CppFactory
+{
+	// each bike gets its own wheels
+	template <>
+	struct SharedDependency<CppFactoryUnitTests::Wheel> : std::false_type
+	{
+	};
+
+	// shapes are squares, unless bound otherwise
+	template <int TZone>
+	struct Implementation<CppFactoryUnitTests::Shape, TZone>
+	{
+		typedef CppFactoryUnitTests::Square type;
+	};
+
+	template <>
+	struct SharedDependency<CppFactoryUnitTests::Shape> : std::false_type
+	{
+	};
+
+	template <>
+	struct StaticAllocator<CppFactoryUnitTests::Data, 122>
+	{
+		static std::shared_ptr<CppFactoryUnitTests::Data> Allocate()
+		{
+			auto data = std::make_shared<CppFactoryUnitTests::Data>();
+			data->Value = 122;
+			return data;
+		}
+	};
+}
+
+namespace CppFactoryUnitTests
+{
 	class CustomFactory : public Factory<DataArgs, int, int>
 	{
 	};
 
+	enum class MessageKind
+	{
+		Ping,
+		Echo,
+		Sum = 5
+	};
+
+	struct Message
+	{
+		virtual ~Message() {}
+		virtual int Payload() const = 0;
+	};
+
+	struct PingMessage : public Message
+	{
+		PingMessage(const std::string& body, int) : Body(body) {}
+		int Payload() const override { return 0; }
+		std::string Body;
+	};
+
+	struct EchoMessage : public Message
+	{
+		EchoMessage(const std::string& body, int value) : Body(body), Value(value) {}
+		int Payload() const override { return Value; }
+		std::string Body;
+		int Value;
+	};
+
+	struct SumMessage : public Message
+	{
+		SumMessage(const std::string& body, int value) : Value(value + static_cast<int>(body.size())) {}
+		int Payload() const override { return Value; }
+		int Value;
+	};
+
 	enum TestZones
 	{
 		ZoneOne,
@@ -58,6 +265,44 @@ namespace CppFactoryUnitTests
 			Assert::AreEqual<int>(20, factory.Allocate(10, 20)->Value2);
 		}
 
+		TEST_METHOD(FactoryKeyed_Success)
+		{
+			Factory<Message, const std::string&, int> factory;
+			factory.Register<PingMessage>(MessageKind::Ping);
+			factory.Register<EchoMessage>(MessageKind::Echo);
+			factory.Register<SumMessage>(MessageKind::Sum);
+
+			std::string body = "abc";
+			Assert::AreEqual<int>(0, factory.Create(MessageKind::Ping, body, 7)->Payload());
+			Assert::AreEqual<int>(7, factory.Create(MessageKind::Echo, body, 7)->Payload());
+			Assert::AreEqual<int>(10, factory.Create(MessageKind::Sum, body, 7)->Payload());
+			Assert::IsTrue(std::dynamic_pointer_cast<EchoMessage>(factory.Create(MessageKind::Echo, body, 7))->Body == body);
+
+			// arguments may be lvalues, including those declared by value
+			int len = 5;
+			const int constLen = 6;
+			Assert::AreEqual<int>(5, factory.Create(MessageKind::Echo, body, len)->Payload());
+			Assert::AreEqual<int>(6, factory.Create(1, body, constLen)->Payload());
+			Assert::AreEqual<int>(5, len);
+
+			// gaps and keys past the table aren't registered
+			Assert::IsFalse(factory.IsRegistered(3));
+			Assert::IsFalse(factory.IsRegistered(-1));
+			Assert::ExpectException<std::out_of_range>([&] { factory.Create(3, body, 7); });
+			Assert::ExpectException<std::out_of_range>([&] { factory.Create(-1, body, 7); });
+
+			// negative keys are rejected before the table is touched
+			Assert::ExpectException<std::out_of_range>([&] { factory.Register<PingMessage>(-1); });
+			Assert::IsFalse(factory.IsRegistered(-1));
+			factory.Unregister(-1);
+			Assert::AreEqual<int>(7, factory.Create(MessageKind::Echo, body, 7)->Payload());
+
+			factory.Unregister(MessageKind::Echo);
+			Assert::IsFalse(factory.IsRegistered(MessageKind::Echo));
+			Assert::IsTrue(factory.IsRegistered(MessageKind::Sum));
+			Assert::ExpectException<std::out_of_range>([&] { factory.Create(MessageKind::Echo, body, 7); });
+		}
+
 		TEST_METHOD(CustomFactory_Success)
 		{
 			CustomFactory factory;
@@ -80,6 +325,10 @@ namespace CppFactoryUnitTests
 
 			// removes all globals
 			GlobalObject<Data>::Reset();
+			WeakGlobalObject<Data>::Reset();
+
+			// restores the default executor
+			Executor::Unregister();
 		}
 
 		TEST_METHOD(Default_Success)
@@ -209,12 +458,1253 @@ namespace CppFactoryUnitTests
 
 				Assert::IsFalse(dealloc);
 
+				// reset defers destruction, collect forces it
 				GlobalObject<Data>::Reset();
+				GlobalObject<Data>::Collect();
 
 				Assert::IsTrue(dealloc);
 			}
 		}
 
+		TEST_METHOD(PooledRecycle_Success)
+		{
+			int allocs = 0;
+			Object<Data>::RegisterAllocator<20>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			Data* first = nullptr;
+
+			// retrieval scope
+			{
+				auto obj = PooledObject<Data>::Get<20>();
+				obj->Value = 30;
+				first = obj.get();
+			}
+
+			// should be the same instance, untouched
+			auto obj = PooledObject<Data>::Get<20>();
+			Assert::IsTrue(first == obj.get());
+			Assert::AreEqual<int>(30, obj->Value);
+			Assert::AreEqual<int>(1, allocs);
+		}
+
+		TEST_METHOD(PooledCrossThread_Success)
+		{
+			std::atomic<int> allocs(0);
+			Object<Data>::RegisterAllocator<21>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			const int count = (int)(PooledObject<Data>::MagazineSize * 2);
+
+			// another thread allocates and releases a batch of objects
+			std::thread([&] {
+				std::vector<std::shared_ptr<Data>> held;
+				for (auto i = 0; i < count; ++i)
+				{
+					held.push_back(PooledObject<Data>::Get<21>());
+				}
+			}).join();
+
+			Assert::AreEqual<int>(count, allocs);
+
+			// which this thread should be able to reuse
+			std::vector<std::shared_ptr<Data>> held;
+			for (auto i = 0; i < count; ++i)
+			{
+				held.push_back(PooledObject<Data>::Get<21>());
+			}
+
+			Assert::AreEqual<int>(count, allocs);
+		}
+
+		TEST_METHOD(PooledConcurrent_Success)
+		{
+			std::atomic<int> allocs(0);
+			Object<Data>::RegisterAllocator<22>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			const int threadCount = 4;
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < threadCount; ++t)
+			{
+				threads.emplace_back([] {
+					for (auto i = 0; i < 1000; ++i)
+					{
+						auto obj = PooledObject<Data>::Get<22>();
+						obj->Value2 = i;
+					}
+				});
+			}
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			// each thread only ever holds one object at a time
+			Assert::IsTrue(allocs <= threadCount);
+		}
+
+		TEST_METHOD(Async_Success)
+		{
+			Assert::AreEqual<int>(10, Object<Data>::GetAsync().get()->Value);
+			Assert::AreEqual<int>(20, GlobalObject<Data>::GetAsync().get()->Value2);
+
+			// should be the same global as the synchronous path
+			Assert::IsTrue(GlobalObject<Data>::Get() == GlobalObject<Data>::GetAsync().get());
+		}
+
+		TEST_METHOD(AsyncCancel_Verify)
+		{
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+
+			int allocs = 0;
+			Object<Data>::RegisterAllocator([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			CancellationToken token;
+			auto obj = Object<Data>::GetAsync(token);
+			auto global = GlobalObject<Data>::GetAsync(token);
+			token.Cancel();
+
+			for (auto& work : queued)
+			{
+				work();
+			}
+
+			Assert::ExpectException<CanceledException>([&] { obj.get(); });
+			Assert::ExpectException<CanceledException>([&] { global.get(); });
+			Assert::AreEqual<int>(0, allocs);
+		}
+
+		TEST_METHOD(AsyncDeadline_Verify)
+		{
+			auto past = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+
+			Assert::ExpectException<DeadlineExceededException>([&] { Object<Data>::GetAsync(past).get(); });
+			Assert::ExpectException<DeadlineExceededException>([&] { GlobalObject<Data>::GetAsync(past).get(); });
+		}
+
+		TEST_METHOD(AsyncCancelRunning_Verify)
+		{
+			std::promise<void> gate;
+			auto opened = gate.get_future().share();
+			Object<Data>::RegisterAllocator([opened] {
+				opened.wait();
+				return std::make_shared<Data>();
+			});
+
+			CancellationToken token;
+			auto obj = Object<Data>::GetAsync(token);
+			auto global = GlobalObject<Data>::GetAsync(std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+
+			// both requests fail while their allocators are still running
+			token.Cancel();
+			Assert::IsTrue(obj.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+			Assert::IsTrue(global.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+			Assert::ExpectException<CanceledException>([&] { obj.get(); });
+			Assert::ExpectException<DeadlineExceededException>([&] { global.get(); });
+
+			// the late global result is still cached for later requests
+			gate.set_value();
+			Assert::AreEqual<int>(10, GlobalObject<Data>::GetAsync().get()->Value);
+		}
+
+		TEST_METHOD(AsyncCoalesce_Verify)
+		{
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+
+			int allocs = 0;
+			Object<Data>::RegisterAllocator([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			auto first = GlobalObject<Data>::GetAsync();
+			auto second = GlobalObject<Data>::GetAsync();
+
+			// both requests should share one allocation
+			Assert::AreEqual<size_t>(1, queued.size());
+			queued[0]();
+
+			Assert::AreEqual<int>(1, allocs);
+			Assert::IsTrue(first.get() == second.get());
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		TEST_METHOD(Coroutine_Success)
+		{
+			RunLoop loop;
+
+			Object<Data>::RegisterAllocator([&]() -> Task<std::shared_ptr<Data>> {
+				// stand-in for asynchronous I/O
+				co_await loop.Schedule();
+
+				auto data = std::make_shared<Data>();
+				data->Value = 0;
+				co_return data;
+			});
+
+			Assert::AreEqual<int>(0, loop.Run(Object<Data>::CoGet())->Value);
+
+			auto global = loop.Run(GlobalObject<Data>::CoGet());
+			Assert::AreEqual<int>(0, global->Value);
+			Assert::IsTrue(global == GlobalObject<Data>::Get());
+
+			// zones without a coroutine allocator still work
+			Assert::AreEqual<int>(10, loop.Run(Object<Data>::CoGet<10>())->Value);
+		}
+
+		TEST_METHOD(CoroutineSync_Success)
+		{
+			Object<Data>::RegisterAllocator([]() -> Task<std::shared_ptr<Data>> {
+				auto data = std::make_shared<Data>();
+				data->Value2 = 0;
+				co_return data;
+			});
+
+			Assert::AreEqual<int>(0, Object<Data>::Get()->Value2);
+			Assert::AreEqual<int>(0, SyncWait(GlobalObject<Data>::CoGet())->Value2);
+		}
+
+		TEST_METHOD(CoroutineCoalesce_Verify)
+		{
+			RunLoop loop;
+
+			int allocs = 0;
+			Object<Data>::RegisterAllocator([&]() -> Task<std::shared_ptr<Data>> {
+				++allocs;
+				co_await loop.Schedule();
+				co_return std::make_shared<Data>();
+			});
+
+			auto both = [&]() -> Task<std::shared_ptr<Data>> {
+				auto first = GlobalObject<Data>::CoGet();
+				auto second = GlobalObject<Data>::CoGet();
+
+				auto a = co_await first;
+				auto b = co_await second;
+				co_return a == b ? a : nullptr;
+			};
+
+			Assert::IsTrue(loop.Run(both()) != nullptr);
+			Assert::AreEqual<int>(1, allocs);
+		}
+
+		TEST_METHOD(CoroutineCycle_Verify)
+		{
+			RunLoop loop;
+
+			// the global is still being built when the allocator resumes, so getting it again is a cycle rather than a deadlock
+			Object<Data>::RegisterAllocator<124>([&]() -> Task<std::shared_ptr<Data>> {
+				co_await loop.Schedule();
+				co_return co_await GlobalObject<Data>::CoGet<124>();
+			});
+
+			Assert::ExpectException<std::logic_error>([&] { loop.Run(GlobalObject<Data>::CoGet<124>()); });
+			Object<Data>::UnregisterAllocator<124>();
+		}
+#endif
+
+		TEST_METHOD(InitializeAll_Success)
+		{
+			std::mutex mutex;
+			std::vector<int> order;
+
+			auto record = [&](int zone) {
+				std::lock_guard<std::mutex> lock(mutex);
+				order.push_back(zone);
+			};
+
+			Object<Data>::RegisterAllocator<30>([&] { record(30); return std::make_shared<Data>(); });
+			Object<Data>::RegisterAllocator<31>([&] { record(31); return std::make_shared<Data>(); });
+			Object<Data>::RegisterAllocator<32>([&] { record(32); return std::make_shared<Data>(); });
+
+			// 31 and 32 both need 30, but not each other
+			GlobalObject<Data>::Register<30>();
+			GlobalObject<Data>::Register<31>({ GlobalObject<Data>::Key<30>() });
+			GlobalObject<Data>::Register<32>({ GlobalObject<Data>::Key<30>() });
+
+			auto timings = InitializeAll();
+
+			GlobalObject<Data>::Unregister<30>();
+			GlobalObject<Data>::Unregister<31>();
+			GlobalObject<Data>::Unregister<32>();
+
+			Assert::AreEqual<size_t>(3, timings.size());
+			Assert::AreEqual<size_t>(3, order.size());
+			Assert::AreEqual<int>(30, order[0]);
+			Assert::IsTrue(timings[0].Key == GlobalObject<Data>::Key<30>());
+
+			// should already be cached
+			Assert::AreEqual<long>(2, GlobalObject<Data>::Get<31>().use_count());
+		}
+
+		TEST_METHOD(InitializeAllCycle_Verify)
+		{
+			GlobalObject<Data>::Register<40>({ GlobalObject<Data>::Key<41>() });
+			GlobalObject<Data>::Register<41>({ GlobalObject<Data>::Key<40>() });
+
+			Assert::ExpectException<std::logic_error>([] { InitializeAll(); });
+
+			GlobalObject<Data>::Unregister<40>();
+			GlobalObject<Data>::Unregister<41>();
+		}
+
+		TEST_METHOD(DeferredDestruction_Verify)
+		{
+			Object<Tracked>::RegisterAllocator([] {
+				return std::shared_ptr<Tracked>(new Tracked(), DeferredDeleter<Tracked>());
+			});
+
+			auto destroyed = Tracked::Destroyed.load();
+
+			Object<Tracked>::Get().reset();
+			Reclaimer::Flush();
+
+			Assert::AreEqual<int>(destroyed + 1, Tracked::Destroyed);
+			Assert::IsTrue(std::this_thread::get_id() != Tracked::DestroyedOn);
+
+			Object<Tracked>::UnregisterAllocator();
+		}
+
+		TEST_METHOD(GlobalResetAsync_Verify)
+		{
+			auto destroyed = Tracked::Destroyed.load();
+
+			GlobalObject<Tracked>::Get();
+			GlobalObject<Tracked>::Get<1>();
+
+			GlobalObject<Tracked>::ResetAsync<1>();
+			GlobalObject<Tracked>::ResetAsync();
+			Reclaimer::Flush();
+
+			Assert::AreEqual<int>(destroyed + 2, Tracked::Destroyed);
+			Assert::IsTrue(std::this_thread::get_id() != Tracked::DestroyedOn);
+		}
+
+		TEST_METHOD(WeakGlobalLifecycle_Success)
+		{
+			int allocs = 0;
+			Object<Data>::RegisterAllocator([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			// retrieval scope
+			{
+				auto obj = WeakGlobalObject<Data>::Get();
+				obj->Value = 100;
+
+				// shared while held
+				Assert::AreEqual<int>(100, WeakGlobalObject<Data>::Get()->Value);
+				Assert::AreEqual<int>(1, allocs);
+
+				// should be just us, the cache doesn't keep it alive
+				Assert::AreEqual<long>(1, obj.use_count());
+			}
+
+			// re-allocated once released
+			Assert::AreEqual<int>(10, WeakGlobalObject<Data>::Get()->Value);
+			Assert::AreEqual<int>(2, allocs);
+		}
+
+		TEST_METHOD(GlobalLifetime_Verify)
+		{
+			int allocs = 0;
+			Object<Data>::RegisterAllocator<50>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			GlobalObject<Data>::SetLifetime<50>(std::chrono::milliseconds(20));
+
+			auto first = GlobalObject<Data>::Get<50>();
+			Assert::IsTrue(first == GlobalObject<Data>::Get<50>());
+			Assert::AreEqual<int>(1, allocs);
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+			// expired, so re-allocated
+			Assert::IsTrue(first != GlobalObject<Data>::Get<50>());
+			Assert::AreEqual<int>(2, allocs);
+
+			GlobalObject<Data>::ClearLifetime<50>();
+		}
+
+		TEST_METHOD(GlobalRefreshAhead_Verify)
+		{
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+
+			int allocs = 0;
+			Object<Data>::RegisterAllocator<51>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			// refresh as soon as possible, but never expire during the test
+			GlobalObject<Data>::SetLifetime<51>(std::chrono::hours(1), std::chrono::hours(1));
+
+			auto first = GlobalObject<Data>::Get<51>();
+
+			// callers keep getting the current object while a single refresh is queued
+			Assert::IsTrue(first == GlobalObject<Data>::Get<51>());
+			Assert::IsTrue(first == GlobalObject<Data>::Get<51>());
+			Assert::AreEqual<size_t>(1, queued.size());
+			Assert::AreEqual<int>(1, allocs);
+
+			queued[0]();
+
+			// swapped in once ready
+			Assert::AreEqual<int>(2, allocs);
+			Assert::IsTrue(first != GlobalObject<Data>::Get<51>());
+
+			GlobalObject<Data>::ClearLifetime<51>();
+		}
+
+		TEST_METHOD(GlobalBudget_Verify)
+		{
+			int allocs = 0;
+			Object<Data>::RegisterAllocator<60>([&] { ++allocs; return std::make_shared<Data>(); });
+			Object<Data>::RegisterAllocator<61>([&] { ++allocs; return std::make_shared<Data>(); });
+			Object<Data>::RegisterAllocator<62>([&] { ++allocs; return std::make_shared<Data>(); });
+
+			GlobalObject<Data>::SetBudget(2);
+
+			GlobalObject<Data>::Get<60>();
+			auto held = GlobalObject<Data>::Get<61>();
+			held->Value = 100;
+
+			// 60 is now more recently used than 61
+			GlobalObject<Data>::Get<60>();
+			GlobalObject<Data>::Get<62>();
+			Assert::AreEqual<int>(3, allocs);
+
+			// 61 was evicted, but stays alive while we hold it
+			Assert::AreEqual<long>(1, held.use_count());
+			Assert::AreEqual<int>(100, held->Value);
+
+			GlobalObject<Data>::Get<60>();
+			Assert::AreEqual<int>(3, allocs);
+			GlobalObject<Data>::Get<61>();
+			Assert::AreEqual<int>(4, allocs);
+
+			// reset zones are still evicted, or swept, as they're replaced
+			GlobalObject<Data>::Reset();
+			GlobalObject<Data>::Get<60>();
+			GlobalObject<Data>::Get<61>();
+			GlobalObject<Data>::Get<62>();
+			GlobalObject<Data>::Get<62>();
+			Assert::AreEqual<int>(7, allocs);
+
+			GlobalObject<Data>::ClearBudget();
+		}
+
+		TEST_METHOD(GlobalResetRace_Verify)
+		{
+			auto race = [](const std::function<void()>& reset) {
+				std::promise<void> entered;
+				std::promise<void> release;
+				auto released = release.get_future().share();
+
+				Object<Data>::RegisterAllocator<132>([&] {
+					entered.set_value();
+					released.wait();
+					return std::make_shared<Data>();
+				});
+
+				std::shared_ptr<Data> first;
+				std::thread getter([&] { first = GlobalObject<Data>::Get<132>(); });
+				entered.get_future().wait();
+				reset();
+				release.set_value();
+				getter.join();
+
+				// the reset raced the allocation, so its object went to the getter, but wasn't cached
+				Object<Data>::RegisterAllocator<132>([] { return std::make_shared<Data>(); });
+				Assert::IsTrue(first.get() != nullptr);
+				Assert::IsTrue(GlobalObject<Data>::Get<132>() != first);
+				Assert::IsTrue(GlobalObject<Data>::Get<132>() == GlobalObject<Data>::Get<132>());
+				GlobalObject<Data>::Reset<132>();
+			};
+
+			race([] { GlobalObject<Data>::Reset(); });
+			race([] { GlobalObject<Data>::Reset<132>(); });
+
+			Object<Data>::UnregisterAllocator<132>();
+		}
+
+		TEST_METHOD(GlobalResetGeneration_Verify)
+		{
+			auto destroyed = Tracked::Destroyed.load();
+
+			auto first = GlobalObject<Tracked>::Get<70>().get();
+			GlobalObject<Tracked>::Get<71>();
+
+			// reset doesn't destroy anything itself
+			GlobalObject<Tracked>::Reset();
+			Assert::AreEqual<int>(destroyed, Tracked::Destroyed);
+
+			GlobalObject<Tracked>::Collect();
+			Assert::AreEqual<int>(destroyed + 2, Tracked::Destroyed);
+
+			// reset entries are misses, even before they're destroyed
+			first = GlobalObject<Tracked>::Get<70>().get();
+			GlobalObject<Tracked>::Reset();
+			Assert::IsTrue(first != GlobalObject<Tracked>::Get<70>().get());
+
+			GlobalObject<Tracked>::Reset();
+			GlobalObject<Tracked>::Collect();
+		}
+
+		TEST_METHOD(GlobalConcurrentReset_Verify)
+		{
+			std::atomic<int> allocs(0);
+			std::atomic<int> deallocs(0);
+			std::atomic<bool> stop(false);
+
+			std::vector<std::thread> readers;
+			for (auto i = 0; i < 4; ++i)
+			{
+				readers.emplace_back([&] {
+					while (!stop)
+					{
+						Assert::AreEqual<int>(10, GlobalObject<Data>::Get<80>()->Value);
+					}
+				});
+			}
+
+			// replace the allocator and the object out from under the readers
+			for (auto i = 0; i < 100; ++i)
+			{
+				Object<Data>::RegisterAllocator<80>([&] {
+					++allocs;
+					return std::shared_ptr<Data>(new Data(), [&](Data* data) { delete data; ++deallocs; });
+				});
+
+				GlobalObject<Data>::Reset<80>();
+			}
+
+			stop = true;
+			for (auto& reader : readers)
+			{
+				reader.join();
+			}
+
+			// once reset returns, everything it cleared has been destroyed
+			GlobalObject<Data>::Reset<80>();
+			Assert::AreEqual<int>(allocs, deallocs);
+
+			Object<Data>::UnregisterAllocator<80>();
+		}
+
+		TEST_METHOD(ZoneFallback_Success)
+		{
+			Object<Data>::RegisterAllocator<90>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 90;
+				return data;
+			});
+
+			Object<Data>::SetFallback<92, 91>();
+			Object<Data>::SetFallback<91, 90>();
+
+			// 92 falls back through 91 to 90
+			Assert::AreEqual<int>(90, Object<Data>::Get<92>()->Value);
+
+			// registering 91 takes effect for 92 as well
+			Object<Data>::RegisterAllocator<91>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 91;
+				return data;
+			});
+			Assert::AreEqual<int>(91, Object<Data>::Get<92>()->Value);
+
+			Object<Data>::UnregisterAllocator<91>();
+			Assert::AreEqual<int>(90, Object<Data>::Get<92>()->Value);
+
+			Assert::ExpectException<std::logic_error>([] { Object<Data>::SetFallback<90, 92>(); });
+
+			Object<Data>::ClearFallback<92>();
+			Assert::AreEqual<int>(10, Object<Data>::Get<92>()->Value);
+
+			Object<Data>::ClearFallback<91>();
+		}
+
+		TEST_METHOD(Lazy_Success)
+		{
+			std::atomic<int> allocs(0);
+			Object<Data>::RegisterAllocator<93>([&] {
+				++allocs;
+				return std::make_shared<Data>();
+			});
+
+			auto lazy = Object<Data>::GetLazy<93>();
+			auto copy = lazy;
+			Assert::AreEqual<int>(0, allocs);
+			Assert::IsFalse(copy.IsValueCreated());
+
+			// copies share a single allocation, even when first used concurrently
+			std::vector<std::thread> users;
+			for (auto i = 0; i < 4; ++i)
+			{
+				users.emplace_back([&] { Assert::AreEqual<int>(10, copy->Value); });
+			}
+
+			for (auto& user : users)
+			{
+				user.join();
+			}
+
+			Assert::AreEqual<int>(1, allocs);
+			Assert::IsTrue(lazy.IsValueCreated());
+			Assert::IsTrue(lazy.Get() == copy.Get());
+			Assert::IsTrue(lazy.operator->() == copy.Get().get());
+			Assert::IsTrue(&*lazy == copy.Get().get());
+
+			auto global = GlobalObject<Data>::GetLazy<93>();
+			Assert::AreEqual<int>(1, allocs);
+			Assert::IsTrue(global.Get() == GlobalObject<Data>::Get<93>());
+			Assert::AreEqual<int>(2, allocs);
+		}
+
+		TEST_METHOD(Trim_Verify)
+		{
+			GlobalObject<Tracked>::Reset();
+			GlobalObject<Tracked>::Collect();
+
+			GlobalObject<Tracked>::SetEvictable<100>();
+			auto evictable = GlobalObject<Tracked>::Get<100>().get();
+			GlobalObject<Tracked>::Get<101>();
+
+			// one more than a magazine holds, so a full magazine is published
+			{
+				std::vector<std::shared_ptr<Tracked>> pooled;
+				for (size_t i = 0; i <= PooledObject<Tracked>::MagazineSize; ++i)
+				{
+					pooled.push_back(PooledObject<Tracked>::Get<102>());
+				}
+			}
+
+			auto destroyed = Tracked::Destroyed.load();
+			MemoryPressure::Trim();
+
+			// the evictable global and the published magazine are released
+			Assert::AreEqual<int>(destroyed + 1 + (int)PooledObject<Tracked>::MagazineSize, Tracked::Destroyed);
+			Assert::IsTrue(evictable != GlobalObject<Tracked>::Get<100>().get());
+
+			GlobalObject<Tracked>::SetEvictable<100>(false);
+			GlobalObject<Tracked>::Reset();
+			GlobalObject<Tracked>::Collect();
+		}
+
+		TEST_METHOD(MemoryPressureWatch_Verify)
+		{
+			const char* path = "CppFactoryPressure.txt";
+
+			{
+				std::ofstream file(path);
+				file << "some avg10=12.50 avg60=3.00 avg300=1.00 total=12345" << std::endl;
+				file << "full avg10=0.00 avg60=0.00 avg300=0.00 total=0" << std::endl;
+			}
+
+			Assert::AreEqual(12.5, MemoryPressure::Read(path));
+			Assert::IsTrue(MemoryPressure::Read("CppFactoryMissing.txt") < 0);
+
+			GlobalObject<Tracked>::SetEvictable<103>();
+			GlobalObject<Tracked>::Get<103>();
+			auto destroyed = Tracked::Destroyed.load();
+
+			// over the threshold, so the watcher trims
+			MemoryPressure::Watch(path, 10, std::chrono::milliseconds(10));
+			for (auto i = 0; i < 100 && Tracked::Destroyed == destroyed; ++i)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+
+			MemoryPressure::Unwatch();
+			Assert::AreEqual<int>(destroyed + 1, Tracked::Destroyed);
+
+			GlobalObject<Tracked>::SetEvictable<103>(false);
+			std::remove(path);
+		}
+
+		TEST_METHOD(PooledReset_Success)
+		{
+			Object<Data>::RegisterReset<104>([](Data& data) { data.Value = 0; });
+
+			Data* first = nullptr;
+
+			// retrieval scope
+			{
+				auto obj = PooledObject<Data>::Get<104>();
+				obj->Value = 30;
+				first = obj.get();
+			}
+
+			// the same instance, reset
+			auto obj = PooledObject<Data>::Get<104>();
+			Assert::IsTrue(first == obj.get());
+			Assert::AreEqual<int>(0, obj->Value);
+			Assert::AreEqual<int>(20, obj->Value2);
+
+			Object<Data>::UnregisterReset<104>();
+		}
+
+		TEST_METHOD(GlobalRefreshReset_Verify)
+		{
+			int allocs = 0;
+			Object<Data>::RegisterAllocator<105>([&] { ++allocs; return std::make_shared<Data>(); });
+			Object<Data>::RegisterReset<105>([](Data& data) { data.Value = 0; });
+
+			// run refreshes when we say so
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+			auto runQueued = [&] {
+				auto work = std::move(queued);
+				queued.clear();
+				for (auto& item : work)
+				{
+					item();
+				}
+			};
+
+			// due for refresh as soon as it is cached
+			GlobalObject<Data>::SetLifetime<105>(std::chrono::minutes(1), std::chrono::minutes(1));
+
+			auto first = GlobalObject<Data>::Get<105>().get();
+			first->Value = 100;
+
+			// nobody else holds it, so the refresh resets it in place
+			GlobalObject<Data>::Get<105>();
+			runQueued();
+			Assert::AreEqual<int>(1, allocs);
+			Assert::IsTrue(first == GlobalObject<Data>::Get<105>().get());
+			Assert::AreEqual<int>(0, first->Value);
+			runQueued();
+
+			// someone else holds it, so the refresh re-allocates
+			auto held = GlobalObject<Data>::Get<105>();
+			runQueued();
+			Assert::AreEqual<int>(2, allocs);
+			Assert::IsTrue(held.get() != GlobalObject<Data>::Get<105>().get());
+			runQueued();
+
+			GlobalObject<Data>::ClearLifetime<105>();
+			Object<Data>::UnregisterReset<105>();
+			Executor::Unregister();
+		}
+
+		TEST_METHOD(GlobalRefreshResetConcurrent_Verify)
+		{
+			Object<Data>::RegisterReset<128>([](Data& data) { data.Value = 0; });
+
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+
+			// due for refresh as soon as it is cached
+			GlobalObject<Data>::SetLifetime<128>(std::chrono::minutes(1), std::chrono::minutes(1));
+			GlobalObject<Data>::Get<128>();
+			GlobalObject<Data>::Get<128>();
+			Assert::AreEqual<size_t>(1, queued.size());
+
+			// another type's reset function gets the global while the refresh is waiting for readers
+			std::promise<void> entered;
+			int seen = 0;
+			Object<Tracked>::RegisterReset<128>([&](Tracked&) {
+				entered.set_value();
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				seen = GlobalObject<Data>::Get<128>()->Value2;
+			});
+
+			std::thread recycler([] { PooledObject<Tracked>::Get<128>(); });
+			entered.get_future().wait();
+			queued[0]();
+			recycler.join();
+
+			Assert::AreEqual<int>(20, seen);
+
+			Object<Tracked>::UnregisterReset<128>();
+			GlobalObject<Data>::ClearLifetime<128>();
+			Object<Data>::UnregisterReset<128>();
+			Executor::Unregister();
+			GlobalObject<Data>::Reset<128>();
+		}
+
+		TEST_METHOD(AutoWire_Success)
+		{
+			auto first = Object<Car>::Get();
+			auto second = Object<Car>::Get();
+
+			// dependencies are globals by default, and come from the same zone
+			Assert::IsTrue(first->CarEngine == GlobalObject<Engine>::Get());
+			Assert::IsTrue(first->CarEngine == second->CarEngine);
+			Assert::IsTrue(first->CarData == second->CarData);
+			Assert::IsTrue(Object<Car>::Get<106>()->CarEngine == GlobalObject<Engine>::Get<106>());
+			Assert::IsTrue(first->CarEngine != GlobalObject<Engine>::Get<106>());
+
+			// registered allocators are used for dependencies too
+			Object<Data>::RegisterAllocator<107>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 107;
+				return data;
+			});
+			Assert::AreEqual<int>(107, Object<Car>::Get<107>()->CarData->Value);
+
+			// types that can't be auto-wired need an allocator, which is checked when getting
+			Assert::ExpectException<std::logic_error>([] { Object<DataArgs>::Get<129>(); });
+			Object<DataArgs>::RegisterAllocator<129>([] { return std::make_shared<DataArgs>(1, 2); });
+			Assert::AreEqual<int>(2, Object<DataArgs>::Get<129>()->Value2);
+			Object<DataArgs>::UnregisterAllocator<129>();
+			Assert::ExpectException<std::logic_error>([] { Object<DataArgs>::Get<129>(); });
+
+			GlobalObject<Engine>::Reset();
+		}
+
+		TEST_METHOD(ConstructionPlan_Verify)
+		{
+			// the first get records the plan, the second replays it
+			auto first = Object<Bike>::Get<108>();
+			auto second = Object<Bike>::Get<108>();
+
+			Assert::IsTrue(first->Front != first->Back);
+			Assert::IsTrue(first->Front != second->Front);
+			Assert::IsTrue(first->BikeEngine == second->BikeEngine);
+			Assert::IsTrue(second->BikeEngine == GlobalObject<Engine>::Get<108>());
+
+			// registering an allocator invalidates the plan
+			std::atomic<int> wheels(0);
+			Object<Wheel>::RegisterAllocator<108>([&] {
+				++wheels;
+				return std::make_shared<Wheel>();
+			});
+
+			Object<Bike>::Get<108>();
+			Object<Bike>::Get<108>();
+			Assert::AreEqual<int>(4, wheels);
+
+			Object<Wheel>::UnregisterAllocator<108>();
+			Object<Bike>::Get<108>();
+			Assert::AreEqual<int>(4, wheels);
+
+			// cycles are reported, rather than recursing or waiting forever
+			Assert::ExpectException<std::logic_error>([] { Object<Chicken>::Get<109>(); });
+			Assert::ExpectException<std::logic_error>([] { GlobalObject<Egg>::Get<109>(); });
+
+			GlobalObject<Engine>::Reset();
+		}
+
+		TEST_METHOD(Scope_Success)
+		{
+			Scope parent;
+			auto child = parent.CreateChild();
+
+			parent.RegisterAllocator<Data, 110>([](const Scope&) {
+				auto data = std::make_shared<Data>();
+				data->Value = 1;
+				return data;
+			});
+
+			// children fall through to their parent
+			Assert::AreEqual<int>(1, child.Get<Data, 110>()->Value);
+			Assert::IsTrue(child.GetGlobal<Data, 110>() == parent.GetGlobal<Data, 110>());
+			Assert::IsTrue(child.Get<Data, 110>() != child.Get<Data, 110>());
+
+			// and may override it, without changing the parent
+			child.RegisterAllocator<Data, 110>([](const Scope&) {
+				auto data = std::make_shared<Data>();
+				data->Value = 2;
+				return data;
+			});
+			Assert::AreEqual<int>(2, child.GetGlobal<Data, 110>()->Value);
+			Assert::AreEqual<int>(1, parent.GetGlobal<Data, 110>()->Value);
+			Assert::IsTrue(child.GetGlobal<Data, 110>() == child.GetGlobal<Data, 110>());
+
+			auto data = std::make_shared<Data>();
+			child.Set<Data, 110>(data);
+			Assert::IsTrue(child.GetGlobal<Data, 110>() == data);
+			Assert::IsTrue(child.CreateChild().GetGlobal<Data, 110>() == data);
+
+			// replaced entries are kept by the scope, then retired in batches
+			for (int i = 0; i < 40; ++i)
+			{
+				child.Set<Data, 110>(std::make_shared<Data>());
+			}
+			child.Set<Data, 110>(data);
+			Assert::IsTrue(child.GetGlobal<Data, 110>() == data);
+
+			// types no scope has fall through to the process-wide state
+			Assert::IsTrue(child.GetGlobal<Data, 111>() == GlobalObject<Data>::Get<111>());
+
+			GlobalObject<Data>::Reset<111>();
+		}
+
+		TEST_METHOD(GetAll_Success)
+		{
+			for (int i = 1; i <= 3; ++i)
+			{
+				Object<Data>::AddAllocator<112>([i] {
+					auto data = std::make_shared<Data>();
+					data->Value = i;
+					return data;
+				});
+			}
+
+			// each allocator runs once, in the order they were added
+			auto all = Object<Data>::GetAll<112>();
+			Assert::AreEqual<size_t>(3, all.size());
+			for (int i = 0; i < 3; ++i)
+			{
+				Assert::AreEqual<int>(i + 1, all[i]->Value);
+			}
+
+			// lists don't affect Get, and are unregistered along with the zone
+			Assert::AreEqual<int>(10, Object<Data>::Get<112>()->Value);
+			Object<Data>::UnregisterAllocator<112>();
+			Assert::AreEqual<size_t>(0, Object<Data>::GetAll<112>().size());
+		}
+
+		TEST_METHOD(Bind_Success)
+		{
+			Assert::AreEqual<int>(4, Object<Shape>::Get<114>()->Sides());
+
+			// the compile time binding is known, so this is a square
+			std::shared_ptr<Square> square = Object<Shape>::GetImplementation<114>();
+			Assert::AreEqual<int>(4, square->Sides());
+
+			Object<Shape>::Bind<Triangle, 114>();
+			Assert::AreEqual<int>(3, Object<Shape>::Get<114>()->Sides());
+			Assert::AreEqual<int>(3, Object<Drawing>::Get<114>()->DrawingShape->Sides());
+			Assert::AreEqual<int>(4, Object<Shape>::GetImplementation<114>()->Sides());
+			Object<Shape>::UnregisterAllocator<114>();
+
+			// bound implementations are auto-wired, both when recording and replaying
+			auto first = Object<Drawing>::Get<115>();
+			auto second = Object<Drawing>::Get<115>();
+			Assert::AreEqual<int>(4, first->DrawingShape->Sides());
+			Assert::AreEqual<int>(4, second->DrawingShape->Sides());
+			Assert::IsTrue(first->DrawingShape != second->DrawingShape);
+		}
+
+		TEST_METHOD(Decorate_Success)
+		{
+			Object<Data>::RegisterAllocator<116>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 1;
+				return data;
+			});
+
+			// each decorator wraps those before it
+			Object<Data>::Decorate<116>([](const Object<Data>::Next& next) {
+				auto data = next();
+				data->Value += 10;
+				return data;
+			});
+			Object<Data>::Decorate<116>([](const Object<Data>::Next& next) {
+				auto data = next();
+				data->Value *= 2;
+				return data;
+			});
+			Assert::AreEqual<int>(22, Object<Data>::Get<116>()->Value);
+
+			// decorators outlive re-registration
+			Object<Data>::RegisterAllocator<116>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 2;
+				return data;
+			});
+			Assert::AreEqual<int>(24, Object<Data>::Get<116>()->Value);
+
+			// and unregistration, wrapping the default construction until the next allocator is registered
+			Object<Data>::UnregisterAllocator<116>();
+			Assert::AreEqual<int>(40, Object<Data>::Get<116>()->Value);
+			Object<Data>::RegisterAllocator<116>([] {
+				auto data = std::make_shared<Data>();
+				data->Value = 3;
+				return data;
+			});
+			Assert::AreEqual<int>(26, Object<Data>::Get<116>()->Value);
+
+			Object<Data>::ClearDecorators<116>();
+			Assert::AreEqual<int>(3, Object<Data>::Get<116>()->Value);
+			Object<Data>::UnregisterAllocator<116>();
+
+			// known decorators are fused, and wrap the default construction when there is no allocator
+			Object<Data>::Decorate<117, AddOne, Double>();
+			Assert::AreEqual<int>(22, Object<Data>::Get<117>()->Value);
+
+			Object<Data>::ClearDecorators<117>();
+			Assert::AreEqual<int>(10, Object<Data>::Get<117>()->Value);
+		}
+
+		TEST_METHOD(Bindings_Success)
+		{
+			Object<Data>::RegisterAllocator("data.one", [] {
+				auto data = std::make_shared<Data>();
+				data->Value = 1;
+				return data;
+			});
+			Object<Data>::RegisterAllocator("data.two", [] {
+				auto data = std::make_shared<Data>();
+				data->Value = 2;
+				return data;
+			});
+
+			// names are per type, so another type's allocator doesn't replace these
+			static std::shared_ptr<Engine> engine = std::make_shared<Engine>();
+			Object<Engine>::RegisterAllocator("data.one", [] { return engine; });
+
+			const char* path = "CppFactoryBindings.txt";
+
+			{
+				std::ofstream file(path);
+				file << "# deployment bindings\n118 = data.two\n\n  119=data.one  # trailing comment\n";
+			}
+
+			Bindings::Load(path);
+			std::remove(path);
+
+			Assert::AreEqual<int>(2, Object<Data>::Get<118>()->Value);
+			Assert::AreEqual<int>(1, Object<Data>::Get<119>()->Value);
+			Assert::IsTrue(Object<Engine>::Get<119>() == engine);
+			Assert::IsTrue(Object<Engine>::Get<118>() != engine);
+
+			// nothing is bound if any line is bad
+			std::istringstream malformed("118 = data.one\n118 data.one\n");
+			Assert::ExpectException<std::invalid_argument>([&] { Bindings::Load(malformed); });
+			std::istringstream unknown("118 = data.three\n");
+			Assert::ExpectException<std::invalid_argument>([&] { Bindings::Load(unknown); });
+			Assert::AreEqual<int>(2, Object<Data>::Get<118>()->Value);
+
+			Object<Data>::UnregisterAllocator<118>();
+			Object<Data>::UnregisterAllocator<119>();
+			Object<Engine>::UnregisterAllocator<119>();
+		}
+
+		TEST_METHOD(Override_Success)
+		{
+			auto mock = std::make_shared<Data>();
+			auto other = 0;
+
+			{
+				Object<Data>::Override<120> outer([] {
+					auto data = std::make_shared<Data>();
+					data->Value = 5;
+					return data;
+				});
+				Assert::AreEqual<int>(5, Object<Data>::Get<120>()->Value);
+
+				{
+					Object<Data>::Override<120> inner([] {
+						auto data = std::make_shared<Data>();
+						data->Value = 6;
+						return data;
+					});
+					Assert::AreEqual<int>(6, Object<Data>::Get<120>()->Value);
+				}
+				Assert::AreEqual<int>(5, Object<Data>::Get<120>()->Value);
+
+				// other threads are unaffected, and so are globals, which they share
+				std::thread([&] { other = Object<Data>::Get<120>()->Value; }).join();
+				Assert::AreEqual<int>(10, other);
+				Assert::AreEqual<int>(10, GlobalObject<Data>::Get<120>()->Value);
+
+				GlobalObject<Data>::Override<120> global(mock);
+				Assert::IsTrue(GlobalObject<Data>::Get<120>() == mock);
+				std::thread([&] { other = GlobalObject<Data>::Get<120>() == mock ? 1 : 0; }).join();
+				Assert::AreEqual<int>(0, other);
+			}
+
+			Assert::AreEqual<int>(10, Object<Data>::Get<120>()->Value);
+			Assert::IsTrue(GlobalObject<Data>::Get<120>() != mock);
+
+			// overrides reach auto-wired dependencies, even once a plan is recorded
+			Object<Bike>::Get<121>();
+			{
+				Object<Wheel>::Override<121> wheel([&] {
+					++other;
+					return std::make_shared<Wheel>();
+				});
+
+				Object<Bike>::Get<121>();
+				Assert::AreEqual<int>(2, other);
+			}
+
+			GlobalObject<Data>::Reset<120>();
+			GlobalObject<Engine>::Reset();
+		}
+
+		TEST_METHOD(OverrideAsync_Success)
+		{
+			std::vector<std::function<void()>> queued;
+			Executor::Register([&](const std::function<void()>& work) { queued.push_back(work); });
+
+			{
+				Object<Data>::Override<130> object([] {
+					auto data = std::make_shared<Data>();
+					data->Value = 99;
+					return data;
+				});
+
+				// the override belongs to this thread, so it is used here rather than on the executor
+				auto future = Object<Data>::GetAsync<130>();
+				Assert::AreEqual<size_t>(0, queued.size());
+				Assert::AreEqual<int>(99, future.get()->Value);
+			}
+
+			auto future = Object<Data>::GetAsync<130>();
+			Assert::AreEqual<size_t>(1, queued.size());
+			queued[0]();
+			Assert::AreEqual<int>(10, future.get()->Value);
+
+			Executor::Unregister();
+		}
+
+		TEST_METHOD(StaticAllocator_Success)
+		{
+			Assert::AreEqual<int>(122, Object<Data>::Get<122>()->Value);
+			Assert::AreEqual<int>(122, GlobalObject<Data>::Get<122>()->Value);
+
+			// declared allocators take the place of registration, but not of overrides
+			Object<Data>::RegisterAllocator<122>([] { return std::make_shared<Data>(); });
+			Assert::AreEqual<int>(122, Object<Data>::Get<122>()->Value);
+
+			{
+				Object<Data>::Override<122> mock([] { return std::make_shared<Data>(); });
+				Assert::AreEqual<int>(10, Object<Data>::Get<122>()->Value);
+			}
+
+			Object<Data>::UnregisterAllocator<122>();
+			GlobalObject<Data>::Reset<122>();
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		TEST_METHOD(OverrideCoroutine_Success)
+		{
+			RunLoop loop;
+			auto mock = std::make_shared<Data>();
+			auto other = 0;
+
+			// the global's allocator resumes before getting its dependency, which still must not see the mock
+			Object<Data>::RegisterAllocator<125>([&]() -> Task<std::shared_ptr<Data>> {
+				co_await loop.Schedule();
+				co_return Object<Data>::Get<126>();
+			});
+
+			{
+				Object<Data>::Override<126> object([] {
+					auto data = std::make_shared<Data>();
+					data->Value = 99;
+					return data;
+				});
+
+				Assert::AreEqual<int>(10, loop.Run(GlobalObject<Data>::CoGet<125>())->Value);
+				std::thread([&] { other = GlobalObject<Data>::Get<125>()->Value; }).join();
+				Assert::AreEqual<int>(10, other);
+
+				GlobalObject<Data>::Override<125> global(mock);
+				Assert::IsTrue(loop.Run(GlobalObject<Data>::CoGet<125>()) == mock);
+				Assert::IsTrue(GlobalObject<Data>::GetAsync<125>().get() == mock);
+			}
+
+			Assert::IsTrue(loop.Run(GlobalObject<Data>::CoGet<125>()) != mock);
+
+			// an Object override takes the place of the zone's coroutine allocator
+			{
+				Object<Data>::Override<125> object([&] { return mock; });
+				Assert::IsTrue(loop.Run(Object<Data>::CoGet<125>()) == mock);
+			}
+
+			Object<Data>::UnregisterAllocator<125>();
+			GlobalObject<Data>::Reset<125>();
+		}
+
+		TEST_METHOD(CoroutinePrecedence_Verify)
+		{
+			RunLoop loop;
+
+			// a declared allocator takes the zone's place, as it does for Get
+			Object<Data>::RegisterAllocator<122>([]() -> Task<std::shared_ptr<Data>> { co_return std::make_shared<Data>(); });
+			Assert::AreEqual<int>(122, loop.Run(Object<Data>::CoGet<122>())->Value);
+			Object<Data>::UnregisterAllocator<122>();
+
+			// decorators wrap the coroutine allocator
+			Object<Data>::RegisterAllocator<131>([]() -> Task<std::shared_ptr<Data>> { co_return std::make_shared<Data>(); });
+			Object<Data>::Decorate<131>([](const Object<Data>::Next& next) {
+				auto data = next();
+				data->Value2 = 77;
+				return data;
+			});
+
+			Assert::AreEqual<int>(77, loop.Run(Object<Data>::CoGet<131>())->Value2);
+
+			Object<Data>::ClearDecorators<131>();
+			Object<Data>::UnregisterAllocator<131>();
+		}
+#endif
+
+		TEST_METHOD(ResetAll_Verify)
+		{
+			// services use a connection, which makes the connection a dependency
+			Object<Service>::RegisterAllocator([] {
+				GlobalObject<Connection>::Get();
+				return std::make_shared<Service>();
+			});
+
+			GlobalObject<Service>::Get();
+			GlobalObject<Tracked>::Get();
+			auto destroyed = Tracked::Destroyed.load();
+
+			TeardownOrder.clear();
+			ResetAll();
+
+			// dependents are torn down first
+			Assert::AreEqual<size_t>(2, TeardownOrder.size());
+			Assert::AreEqual<int>(1, TeardownOrder[0]);
+			Assert::AreEqual<int>(2, TeardownOrder[1]);
+
+			// unrelated types are torn down too
+			Assert::AreEqual<int>(destroyed + 1, Tracked::Destroyed);
+
+			Object<Service>::UnregisterAllocator();
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		TEST_METHOD(ResetAllCoroutine_Verify)
+		{
+			RunLoop loop;
+
+			// the connection is gotten after the allocator resumes, and is still recorded as a dependency
+			Object<Service>::RegisterAllocator([&]() -> Task<std::shared_ptr<Service>> {
+				co_await loop.Schedule();
+				co_await GlobalObject<Connection>::CoGet();
+				co_return std::make_shared<Service>();
+			});
+
+			loop.Run(GlobalObject<Service>::CoGet());
+
+			TeardownOrder.clear();
+			ResetAll();
+
+			Assert::AreEqual<size_t>(2, TeardownOrder.size());
+			Assert::AreEqual<int>(1, TeardownOrder[0]);
+			Assert::AreEqual<int>(2, TeardownOrder[1]);
+
+			Object<Service>::UnregisterAllocator();
+		}
+#endif
+
 		BEGIN_TEST_METHOD_ATTRIBUTE(Timings)
 			TEST_IGNORE()
 		END_TEST_METHOD_ATTRIBUTE()
@@ -313,4 +1803,4 @@ namespace CppFactoryUnitTests
 			}
 		}
 	};
-}
\ No newline at end of file
+}
\ No newline at end of file
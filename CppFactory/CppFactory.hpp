@@ -1,191 +1,6481 @@
 #pragma once
 
 #include <map>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
 #include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <deque>
+#include <optional>
+#define CPPFACTORY_COROUTINES 1
+#endif
+#endif
 
 /// <summary>
-/// Modern c++ object factory implementation in <200 lines
+/// Modern c++ object factory and dependency injection implementation in a single header
 /// </summary>
 /// <remarks>
-/// Version 0.3.0
+/// Version 0.4.0
 /// </remarks>
 namespace CppFactory
 {
+	template <class TObject>
+	class Object;
+
+	template <class TObject>
+	class PooledObject;
+
 	/// <summary>
-	/// Represents an <see cref="Object"/> that has a global lifetime, meaning
-	/// it doesn't get destroyed when it leaves scope
+	/// Thrown by the future of an asynchronous get that was canceled
 	/// </summary>
-	/// <param name="TObject">The type of object</param>
-	template <class TObject>
-	class GlobalObject
+	class CanceledException : public std::runtime_error
+	{
+	public:
+		CanceledException() : std::runtime_error("the operation was canceled")
+		{
+		}
+	};
+
+	/// <summary>
+	/// Thrown by the future of an asynchronous get that did not complete before its deadline
+	/// </summary>
+	class DeadlineExceededException : public std::runtime_error
+	{
+	public:
+		DeadlineExceededException() : std::runtime_error("the operation did not complete before its deadline")
+		{
+		}
+	};
+
+	/// <summary>
+	/// Represents a request to cancel one or more asynchronous gets. Copies share the same state
+	/// </summary>
+	class CancellationToken
 	{
 	public:
+		CancellationToken() : m_state(std::make_shared<State>())
+		{
+		}
+
 		/// <summary>
-		/// Gets (and allocates, if needed) a global object (optionally from a particular zone) for type <c>TObject</c>
+		/// Requests cancellation. Work that has not started yet will not run, and requests fail right away
 		/// </summary>
-		/// <param name="TZone">The zone to get from</param>
-		/// <returns>The object</returns>
-		/// <example>
-		/// GlobalObject&lt;TObject&gt;::Get();
-		/// </example>
-		template <int TZone = 0>
-		static std::shared_ptr<TObject> Get()
+		void Cancel()
 		{
-			if (m_allocObjMap[TZone].get() == nullptr)
+			if (m_state->Canceled.exchange(true))
+			{
+				return;
+			}
+
+			std::map<size_t, std::function<void()>> callbacks;
 			{
-				m_allocObjMap[TZone] = Object<TObject>::Get<TZone>();
+				std::lock_guard<std::mutex> lock(m_state->Mutex);
+				callbacks.swap(m_state->Callbacks);
 			}
 
-			return m_allocObjMap[TZone];
+			for (auto& callback : callbacks)
+			{
+				callback.second();
+			}
 		}
 
 		/// <summary>
-		/// Resets the global object cache for all zones for type <c>TObject</c>
+		/// Determines if cancellation has been requested
 		/// </summary>
-		/// <param name="TZone">The zone to reset</param>
-		/// <example>
-		/// GlobalObject&lt;TObject&gt;::Reset<1>();
-		/// </example>
-		template <int TZone>
-		static void Reset()
+		/// <returns>true if canceled</returns>
+		bool IsCanceled() const
 		{
-			m_allocObjMap[TZone].reset();
+			return m_state->Canceled.load();
 		}
 
 		/// <summary>
-		/// Resets the global object cache for all zones for type <c>TObject</c>
+		/// Registers a callback to run when cancellation is requested, or right away if it already has been
 		/// </summary>
-		/// <example>
-		/// GlobalObject&lt;TObject&gt;::Reset();
-		/// </example>
-		static void Reset()
+		/// <param name="callback">The callback to run</param>
+		/// <returns>An id for <see cref="Unregister"/>, or 0 if the callback already ran</returns>
+		size_t Register(const std::function<void()>& callback) const
 		{
-			m_allocObjMap.clear();
+			{
+				std::lock_guard<std::mutex> lock(m_state->Mutex);
+
+				if (!m_state->Canceled.load())
+				{
+					auto id = ++m_state->LastId;
+					m_state->Callbacks.insert(std::make_pair(id, callback));
+					return id;
+				}
+			}
+
+			callback();
+			return 0;
 		}
-	private:
+
 		/// <summary>
-		/// The type of the allocated object map
+		/// Unregisters a callback that hasn't run yet
 		/// </summary>
-		typedef std::map<int, std::shared_ptr<TObject>> AllocObjMapType;
+		/// <param name="id">The id from <see cref="Register"/></param>
+		void Unregister(size_t id) const
+		{
+			std::lock_guard<std::mutex> lock(m_state->Mutex);
+			m_state->Callbacks.erase(id);
+		}
 
+	private:
 		/// <summary>
-		/// The allocated object map
+		/// The state shared by copies of a token
 		/// </summary>
-		static AllocObjMapType m_allocObjMap;
-	};
+		struct State
+		{
+			State() : Canceled(false), LastId(0)
+			{
+			}
 
-	template <class TObject>
-	typename GlobalObject<TObject>::AllocObjMapType GlobalObject<TObject>::m_allocObjMap = GlobalObject<TObject>::AllocObjMapType();
+			std::atomic<bool> Canceled;
+			std::mutex Mutex;
+			size_t LastId;
+			std::map<size_t, std::function<void()>> Callbacks;
+		};
+
+		std::shared_ptr<State> m_state;
+	};
 
 	/// <summary>
-	/// Represents an object that is created via a "factory"
+	/// Represents the executor that asynchronous gets run allocators on
 	/// </summary>
-	/// <param name="TObject">The type of object</param>
-	template <class TObject>
-	class Object
+	/// <remarks>
+	/// By default, each piece of work runs on its own detached thread
+	/// </remarks>
+	class Executor
 	{
 	public:
 		/// <summary>
-		/// Registers logic capable of allocating (and optionally deallocating) an object of type <c>TObject</c>
+		/// The type of a function that runs work, typically by queuing it to a thread pool
 		/// </summary>
-		/// <param name="TZone">The zone to register for</param>
-		/// <param name="alloc">Function that allocates an object</param>
+		typedef std::function<void(const std::function<void()>&)> ExecuteFuncType;
+
+		/// <summary>
+		/// Registers logic capable of running work asynchronously
+		/// </summary>
+		/// <param name="execute">Function that runs the given work</param>
 		/// <example>
-		/// Object&lt;TObject&gt;::RegisterAllocator([] { return std::make_shared<TObject>(); });
+		/// Executor::Register([&amp;](const std::function&lt;void()&gt;&amp; work) { pool.Queue(work); });
 		/// </example>
-		template <int TZone = 0>
-		static void RegisterAllocator(const std::function<std::shared_ptr<TObject>()>& alloc)
+		static void Register(const ExecuteFuncType& execute)
 		{
-			m_allocFunc[TZone] = alloc;
+			std::lock_guard<std::mutex> lock(Mutex());
+			Func() = execute;
 		}
 
 		/// <summary>
-		/// Unregisters all allocators for all zones for type <c>TObject</c>
+		/// Unregisters the custom executor, restoring the default
 		/// </summary>
 		/// <example>
-		/// Object&lt;TObject&gt;::UnregisterAllocator();
+		/// Executor::Unregister();
 		/// </example>
-		static void UnregisterAllocator()
+		static void Unregister()
 		{
-			m_allocFunc.clear();
+			Register(nullptr);
 		}
-		
+
 		/// <summary>
-		/// Unregisters all allocators for a particular zone for type <c>TObject</c>
+		/// Runs work on the registered executor
 		/// </summary>
-		/// <param name="TZone">The zone to unregister</param>
+		/// <param name="work">The work to run</param>
+		static void Execute(const std::function<void()>& work)
+		{
+			ExecuteFuncType execute;
+			{
+				std::lock_guard<std::mutex> lock(Mutex());
+				execute = Func();
+			}
+
+			if (execute)
+			{
+				execute(work);
+			}
+			else
+			{
+				std::thread(work).detach();
+			}
+		}
+
+	private:
+		static std::mutex& Mutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static ExecuteFuncType& Func()
+		{
+			static ExecuteFuncType func;
+			return func;
+		}
+	};
+
+	/// <summary>
+	/// Represents the background thread that runs callbacks when deadlines pass
+	/// </summary>
+	class Timer
+	{
+	public:
+		/// <summary>
+		/// Schedules a callback to run on the timer thread once a deadline passes
+		/// </summary>
+		/// <param name="deadline">When to run the callback</param>
+		/// <param name="callback">The callback to run</param>
+		/// <returns>An id for <see cref="Cancel"/>, or 0 if the callback will never run</returns>
 		/// <example>
-		/// Object&lt;TObject&gt;::UnregisterAllocator(10);
+		/// Timer::Schedule(std::chrono::steady_clock::now() + std::chrono::seconds(1), [] { ... });
 		/// </example>
-		template<int TZone>
-		static void UnregisterAllocator()
+		static size_t Schedule(std::chrono::steady_clock::time_point deadline, const std::function<void()>& callback)
 		{
-			m_allocFunc[TZone].erase(zone);
+			// during shutdown there's no thread left to run it
+			if (deadline == std::chrono::steady_clock::time_point::max() || IsShutdown())
+			{
+				return 0;
+			}
+
+			return Instance().Push(deadline, callback);
 		}
 
 		/// <summary>
-		/// Gets (and allocates, if needed) an object (optionally from a particular zone) for type <c>TObject</c>
+		/// Cancels a callback that hasn't run yet
 		/// </summary>
-		/// <param name="TZone">The zone to get from</param>
-		/// <returns>The object</returns>
+		/// <param name="id">The id from <see cref="Schedule"/></param>
 		/// <example>
-		/// Object<TObject>::Get();
+		/// Timer::Cancel(id);
 		/// </example>
-		template <int TZone = 0>
-		static std::shared_ptr<TObject> Get()
+		static void Cancel(size_t id)
 		{
-			std::shared_ptr<TObject> obj;
+			if (id != 0 && !IsShutdown())
+			{
+				Instance().Remove(id);
+			}
+		}
 
-			// if we have a custom allocator use it
-			if (m_allocFunc.find(TZone) == m_allocFunc.end())
+	private:
+		/// <summary>
+		/// A callback waiting for its deadline
+		/// </summary>
+		struct Item
+		{
+			size_t Id;
+			std::function<void()> Callback;
+		};
+
+		typedef std::multimap<std::chrono::steady_clock::time_point, Item> QueueType;
+
+		class State
+		{
+		public:
+			State() : m_stop(false), m_lastId(0)
 			{
-				// TODO(bengreenier): support not default ctors
-				//
-				// If compilation is failing here, you may have a ctor with parameters or a non-public ctor
-				// Non-public: add `friend Object<TObject>;`
-				// Parameters: not supported yet
-				obj = std::shared_ptr<TObject>(new TObject());
+				m_thread = std::thread([this] { Run(); });
 			}
-			else
+
+			~State()
 			{
-				obj = m_allocFunc[TZone]();
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_stop = true;
+					m_wake.notify_one();
+				}
+
+				m_thread.join();
+				IsShutdown() = true;
 			}
 
-			return obj;
+			size_t Push(std::chrono::steady_clock::time_point deadline, const std::function<void()>& callback)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto id = ++m_lastId;
+				auto it = m_queue.insert(std::make_pair(deadline, Item{ id, callback }));
+				m_index.insert(std::make_pair(id, it));
+
+				if (it == m_queue.begin())
+				{
+					m_wake.notify_one();
+				}
+
+				return id;
+			}
+
+			void Remove(size_t id)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto found = m_index.find(id);
+				if (found != m_index.end())
+				{
+					m_queue.erase(found->second);
+					m_index.erase(found);
+				}
+			}
+
+		private:
+			void Run()
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				while (!m_stop)
+				{
+					if (m_queue.empty())
+					{
+						m_wake.wait(lock);
+						continue;
+					}
+
+					auto next = m_queue.begin();
+					if (std::chrono::steady_clock::now() < next->first)
+					{
+						m_wake.wait_until(lock, next->first);
+						continue;
+					}
+
+					auto callback = std::move(next->second.Callback);
+					m_index.erase(next->second.Id);
+					m_queue.erase(next);
+
+					lock.unlock();
+					callback();
+					lock.lock();
+				}
+			}
+
+			bool m_stop;
+			size_t m_lastId;
+			QueueType m_queue;
+			std::map<size_t, QueueType::iterator> m_index;
+			std::mutex m_mutex;
+			std::condition_variable m_wake;
+			std::thread m_thread;
+		};
+
+		static State& Instance()
+		{
+			static State state;
+			return state;
+		}
+
+		static bool& IsShutdown()
+		{
+			static bool shutdown = false;
+			return shutdown;
+		}
+	};
+
+	/// <summary>
+	/// Represents the result of an asynchronous get, which completes once: when its result arrives, or as soon as it is
+	/// canceled or its deadline passes, in which case a late result is dropped
+	/// </summary>
+	/// <param name="TResult">The type of result</param>
+	template <class TResult>
+	class AsyncRequest
+	{
+	public:
+		/// <summary>
+		/// Creates a request that watches a token and a deadline
+		/// </summary>
+		/// <param name="token">Token that cancels the request</param>
+		/// <param name="deadline">The time by which the result must arrive</param>
+		/// <returns>The request</returns>
+		static std::shared_ptr<AsyncRequest> Create(const CancellationToken& token, std::chrono::steady_clock::time_point deadline)
+		{
+			std::shared_ptr<AsyncRequest> request(new AsyncRequest(token, deadline));
+			std::weak_ptr<AsyncRequest> weak = request;
+
+			auto cancelId = token.Register([weak] {
+				if (auto watched = weak.lock())
+				{
+					watched->Finish(nullptr, std::make_exception_ptr(CanceledException()));
+				}
+			});
+
+			auto timerId = Timer::Schedule(deadline, [weak] {
+				if (auto watched = weak.lock())
+				{
+					watched->Finish(nullptr, std::make_exception_ptr(DeadlineExceededException()));
+				}
+			});
+
+			bool finished;
+			{
+				std::lock_guard<std::mutex> lock(request->m_mutex);
+				request->m_cancelId = cancelId;
+				request->m_timerId = timerId;
+				finished = request->m_finished;
+			}
+
+			// the request may have failed while its watchers were being registered
+			if (finished)
+			{
+				request->Unwatch();
+			}
+
+			return request;
+		}
+
+		/// <summary>
+		/// Gets the future for the result. May only be called once
+		/// </summary>
+		std::future<TResult> GetFuture()
+		{
+			return m_promise.get_future();
+		}
+
+		/// <summary>
+		/// Determines if the request no longer wants a result
+		/// </summary>
+		bool IsAbandoned() const
+		{
+			return m_token.IsCanceled() || std::chrono::steady_clock::now() > m_deadline;
+		}
+
+		/// <summary>
+		/// Delivers a result, unless the request was canceled or its deadline passed
+		/// </summary>
+		/// <param name="result">The result</param>
+		/// <param name="error">The error, if producing the result failed</param>
+		void Complete(const TResult& result, const std::exception_ptr& error)
+		{
+			if (m_token.IsCanceled())
+			{
+				Finish(nullptr, std::make_exception_ptr(CanceledException()));
+			}
+			else if (std::chrono::steady_clock::now() > m_deadline)
+			{
+				Finish(nullptr, std::make_exception_ptr(DeadlineExceededException()));
+			}
+			else
+			{
+				Finish(&result, error);
+			}
 		}
 
 	private:
+		AsyncRequest(const CancellationToken& token, std::chrono::steady_clock::time_point deadline) :
+			m_token(token),
+			m_deadline(deadline),
+			m_finished(false),
+			m_cancelId(0),
+			m_timerId(0)
+		{
+		}
+
 		/// <summary>
-		/// The type of the allocator function map
+		/// Completes the promise, if nothing else has
 		/// </summary>
-		typedef std::map<int, std::function<std::shared_ptr<TObject>()>> AllocFuncMapType;
+		void Finish(const TResult* result, const std::exception_ptr& error)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				if (m_finished)
+				{
+					return;
+				}
+
+				m_finished = true;
+			}
+
+			if (error)
+			{
+				m_promise.set_exception(error);
+			}
+			else
+			{
+				m_promise.set_value(*result);
+			}
+
+			Unwatch();
+		}
 
 		/// <summary>
-		/// The allocator function map
+		/// Stops watching the token and the deadline. Each id is released once, by whoever sees it first
 		/// </summary>
-		static AllocFuncMapType m_allocFunc;
-	};
+		void Unwatch()
+		{
+			size_t cancelId;
+			size_t timerId;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				cancelId = m_cancelId;
+				timerId = m_timerId;
+				m_cancelId = 0;
+				m_timerId = 0;
+			}
 
-	template <class TObject>
-	typename Object<TObject>::AllocFuncMapType Object<TObject>::m_allocFunc = Object<TObject>::AllocFuncMapType();
+			if (cancelId != 0)
+			{
+				m_token.Unregister(cancelId);
+			}
+
+			Timer::Cancel(timerId);
+		}
 
+		CancellationToken m_token;
+		std::chrono::steady_clock::time_point m_deadline;
+		std::promise<TResult> m_promise;
+		std::mutex m_mutex;
+		bool m_finished;
+		size_t m_cancelId;
+		size_t m_timerId;
+	};
 
 	/// <summary>
-	/// Represents a traditional factory capable of creating allocating objects
+	/// Represents the background thread that destroys objects handed to it, in batches, so that expensive teardown
+	/// doesn't run on the thread that released them
 	/// </summary>
-	/// <param name="TObject">The type of object</param>
-	/// <param name="Args">The ctor argument types for the object constructor</param>
-	template <class TObject, class ...Args>
-	class Factory
+	class Reclaimer
 	{
 	public:
 		/// <summary>
-		/// Allocates an instance of type <see cref="TObject"/>
+		/// Queues an object to be destroyed (via <c>delete</c>) on the reclamation thread
 		/// </summary>
-		virtual std::shared_ptr<TObject> Allocate(Args&&... args)
+		/// <param name="obj">The object to destroy</param>
+		/// <example>
+		/// Reclaimer::Retire(obj);
+		/// </example>
+		template <class TObject>
+		static void Retire(TObject* obj)
 		{
-			return std::make_shared<TObject>(args...);
+			if (obj == nullptr)
+			{
+				return;
+			}
+
+			// during shutdown there's no thread left to hand off to
+			if (IsShutdown())
+			{
+				delete obj;
+				return;
+			}
+
+			Instance().Push(obj, [](void* retired) { delete static_cast<TObject*>(retired); });
 		}
+
+		/// <summary>
+		/// Blocks until everything retired before the call has been destroyed
+		/// </summary>
+		/// <example>
+		/// Reclaimer::Flush();
+		/// </example>
+		static void Flush()
+		{
+			if (!IsShutdown())
+			{
+				Instance().Flush();
+			}
+		}
+
+	private:
+		/// <summary>
+		/// An object waiting to be destroyed, along with how to destroy it
+		/// </summary>
+		struct Item
+		{
+			void* Object;
+			void(*Destroy)(void*);
+		};
+
+		class State
+		{
+		public:
+			State() : m_stop(false), m_retired(0), m_reclaimed(0)
+			{
+				m_thread = std::thread([this] { Run(); });
+			}
+
+			~State()
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_stop = true;
+					m_wake.notify_one();
+				}
+
+				m_thread.join();
+				IsShutdown() = true;
+			}
+
+			void Push(void* obj, void(*destroy)(void*))
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_queue.push_back(Item{ obj, destroy });
+				++m_retired;
+				m_wake.notify_one();
+			}
+
+			void Flush()
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				auto target = m_retired;
+				m_idle.wait(lock, [&] { return m_reclaimed >= target; });
+			}
+
+		private:
+			void Run()
+			{
+				std::vector<Item> batch;
+				std::unique_lock<std::mutex> lock(m_mutex);
+
+				for (;;)
+				{
+					m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+					if (m_queue.empty())
+					{
+						return;
+					}
+
+					// take everything queued so far, and destroy it without holding the lock
+					batch.swap(m_queue);
+					lock.unlock();
+
+					for (auto& item : batch)
+					{
+						item.Destroy(item.Object);
+					}
+
+					lock.lock();
+					m_reclaimed += batch.size();
+					batch.clear();
+					m_idle.notify_all();
+				}
+			}
+
+			std::mutex m_mutex;
+			std::condition_variable m_wake;
+			std::condition_variable m_idle;
+			std::vector<Item> m_queue;
+			bool m_stop;
+			uint64_t m_retired;
+			uint64_t m_reclaimed;
+			std::thread m_thread;
+		};
+
+		static State& Instance()
+		{
+			static State state;
+			return state;
+		}
+
+		/// <summary>
+		/// Trivially destructible, so this remains readable after the reclamation thread is gone
+		/// </summary>
+		static bool& IsShutdown()
+		{
+			static bool shutdown = false;
+			return shutdown;
+		}
+	};
+
+	/// <summary>
+	/// Deleter that destroys an object on the <see cref="Reclaimer"/> thread, rather than the thread that released it
+	/// </summary>
+	/// <param name="TObject">The type of object</param>
+	/// <example>
+	/// Object&lt;TObject&gt;::RegisterAllocator([] { return std::shared_ptr&lt;TObject&gt;(new TObject(), DeferredDeleter&lt;TObject&gt;()); });
+	/// </example>
+	template <class TObject>
+	struct DeferredDeleter
+	{
+		void operator()(TObject* obj) const
+		{
+			Reclaimer::Retire(obj);
+		}
+	};
+
+	/// <summary>
+	/// Represents epoch-based reclamation, which lets readers use shared objects without taking locks. Writers unpublish an object
+	/// and retire it, and it is destroyed once no reader can still see it
+	/// </summary>
+	/// <remarks>
+	/// Each thread announces the epoch it entered a <see cref="Guard"/> in. An object retired in some epoch is destroyed once every
+	/// thread inside a guard entered after that epoch, which costs readers a couple of stores to their own cache line
+	/// </remarks>
+	class Epoch
+	{
+		struct Record;
+
+	public:
+		/// <summary>
+		/// Marks a read-side critical section. Objects loaded inside one stay alive until it ends. Guards may be nested, but must
+		/// not block, so code that runs user callbacks should copy what it needs out of the guard first
+		/// </summary>
+		/// <example>
+		/// Epoch::Guard guard;
+		/// </example>
+		class Guard
+		{
+		public:
+			Guard() : m_record(Local()), m_owned(false)
+			{
+				// the thread is tearing down, so borrow a record just for this guard
+				if (m_record == nullptr)
+				{
+					m_record = Acquire();
+					m_owned = true;
+				}
+
+				if (m_record->Depth++ == 0)
+				{
+					m_record->Observed.store(Current().load());
+				}
+			}
+
+			~Guard()
+			{
+				if (--m_record->Depth == 0)
+				{
+					m_record->Observed.store(Inactive);
+				}
+
+				if (m_owned)
+				{
+					m_record->InUse.store(false);
+				}
+			}
+
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+
+		private:
+			Record* m_record;
+			bool m_owned;
+		};
+
+		/// <summary>
+		/// Destroys an object (via <c>TDeleter</c>) once no reader can still see it. The object must already be unpublished
+		/// </summary>
+		/// <param name="obj">The object to destroy</param>
+		/// <example>
+		/// Epoch::Retire(slot.exchange(replacement));
+		/// </example>
+		template <class TObject, class TDeleter = std::default_delete<TObject>>
+		static void Retire(TObject* obj)
+		{
+			if (obj == nullptr)
+			{
+				return;
+			}
+
+			auto destroy = [](void* retired) { TDeleter()(static_cast<TObject*>(retired)); };
+
+			if (IsShutdown())
+			{
+				destroy(obj);
+				return;
+			}
+
+			Instance().Push(obj, destroy);
+		}
+
+		/// <summary>
+		/// Blocks until everything retired before the call has been destroyed
+		/// </summary>
+		/// <remarks>
+		/// Called from inside a <see cref="Guard"/>, this can't wait for the caller itself, so it only destroys what is already safe to
+		/// </remarks>
+		/// <example>
+		/// Epoch::Synchronize();
+		/// </example>
+		static void Synchronize()
+		{
+			if (!IsShutdown())
+			{
+				auto local = Local();
+				Instance().Reclaim(local == nullptr || local->Depth == 0);
+			}
+		}
+
+		/// <summary>
+		/// Blocks until every thread that was inside a <see cref="Guard"/> at the time of the call has left it, without destroying anything
+		/// </summary>
+		/// <returns>false if called from inside a guard, in which case it can't wait for the caller itself and returns right away</returns>
+		/// <example>
+		/// slot.exchange(nullptr);
+		/// Epoch::Wait();
+		/// </example>
+		static bool Wait()
+		{
+			auto local = Local();
+			if (local != nullptr && local->Depth > 0)
+			{
+				return false;
+			}
+
+			auto target = Current().fetch_add(1) + 1;
+			while (Oldest() < target)
+			{
+				std::this_thread::yield();
+			}
+
+			return true;
+		}
+
+	private:
+		/// <summary>
+		/// The epoch announced by a thread that isn't inside a guard
+		/// </summary>
+		static const uint64_t Inactive = std::numeric_limits<uint64_t>::max();
+
+		/// <summary>
+		/// The epoch a thread entered its outermost guard in. Records are reused by later threads, and never freed
+		/// </summary>
+		struct Record
+		{
+			Record() : Observed(Inactive), InUse(true), Depth(0), Next(nullptr)
+			{
+			}
+
+			std::atomic<uint64_t> Observed;
+			std::atomic<bool> InUse;
+			size_t Depth;
+			Record* Next;
+		};
+
+		/// <summary>
+		/// An object waiting to be destroyed, along with how to destroy it and the epoch it was retired in
+		/// </summary>
+		struct Item
+		{
+			void* Object;
+			void(*Destroy)(void*);
+			uint64_t RetiredAt;
+		};
+
+		/// <summary>
+		/// Releases the calling thread's record when it exits
+		/// </summary>
+		class LocalRecord
+		{
+		public:
+			LocalRecord(bool& destroyed) : m_record(Acquire()), m_destroyed(destroyed)
+			{
+			}
+
+			~LocalRecord()
+			{
+				m_destroyed = true;
+				m_record->InUse.store(false);
+			}
+
+			Record* Get() const
+			{
+				return m_record;
+			}
+
+		private:
+			Record* m_record;
+			bool& m_destroyed;
+		};
+
+		class State
+		{
+		public:
+			~State()
+			{
+				for (auto& item : m_retired)
+				{
+					item.Destroy(item.Object);
+				}
+
+				IsShutdown() = true;
+			}
+
+			void Push(void* obj, void(*destroy)(void*))
+			{
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_retired.push_back(Item{ obj, destroy, Current().load() });
+				}
+
+				// usually nobody is reading, in which case this destroys the object right away
+				Reclaim(false);
+			}
+
+			void Reclaim(bool wait)
+			{
+				// threads that enter a guard from now on can't see anything retired so far
+				auto target = Current().fetch_add(1) + 1;
+				auto oldest = Oldest();
+
+				while (wait && oldest < target)
+				{
+					std::this_thread::yield();
+					oldest = Oldest();
+				}
+
+				auto limit = std::min(oldest, target);
+				std::vector<Item> ready;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+
+					auto split = std::partition(m_retired.begin(), m_retired.end(), [&](const Item& item) { return item.RetiredAt >= limit; });
+					ready.assign(split, m_retired.end());
+					m_retired.erase(split, m_retired.end());
+				}
+
+				// destroy without holding the lock, in case destructors retire more
+				for (auto& item : ready)
+				{
+					item.Destroy(item.Object);
+				}
+			}
+
+		private:
+			std::mutex m_mutex;
+			std::vector<Item> m_retired;
+		};
+
+		/// <summary>
+		/// Gets the oldest epoch announced by a thread inside a guard, or <c>Inactive</c> if there is none
+		/// </summary>
+		static uint64_t Oldest()
+		{
+			auto oldest = Inactive;
+			for (auto record = Records().load(); record != nullptr; record = record->Next)
+			{
+				oldest = std::min(oldest, record->Observed.load());
+			}
+
+			return oldest;
+		}
+
+		/// <summary>
+		/// Claims an unused record, or adds a new one
+		/// </summary>
+		static Record* Acquire()
+		{
+			for (auto record = Records().load(); record != nullptr; record = record->Next)
+			{
+				auto unused = false;
+				if (record->InUse.compare_exchange_strong(unused, true))
+				{
+					return record;
+				}
+			}
+
+			auto record = new Record();
+			record->Next = Records().load();
+			while (!Records().compare_exchange_weak(record->Next, record))
+			{
+			}
+
+			return record;
+		}
+
+		/// <summary>
+		/// Gets the calling thread's record, or nullptr if the thread is tearing down
+		/// </summary>
+		static Record* Local()
+		{
+			// trivially destructible, so this remains readable while the thread tears down
+			static thread_local bool destroyed = false;
+			if (destroyed)
+			{
+				return nullptr;
+			}
+
+			static thread_local LocalRecord local(destroyed);
+			return local.Get();
+		}
+
+		/// <summary>
+		/// The current epoch. Trivially destructible, so this remains usable during shutdown
+		/// </summary>
+		static std::atomic<uint64_t>& Current()
+		{
+			static std::atomic<uint64_t> current(1);
+			return current;
+		}
+
+		/// <summary>
+		/// The list of thread records. Trivially destructible, so this remains usable during shutdown
+		/// </summary>
+		static std::atomic<Record*>& Records()
+		{
+			static std::atomic<Record*> records(nullptr);
+			return records;
+		}
+
+		static State& Instance()
+		{
+			static State state;
+			return state;
+		}
+
+		/// <summary>
+		/// Trivially destructible, so this remains readable after the retired list is gone
+		/// </summary>
+		static bool& IsShutdown()
+		{
+			static bool shutdown = false;
+			return shutdown;
+		}
+	};
+
+	/// <summary>
+	/// Releases memory that caches and pools hold on to, on request or when a pressure file reports that memory is short
+	/// </summary>
+	/// <remarks>
+	/// <see cref="GlobalObject"/> and <see cref="PooledObject"/> types add themselves once used, so <see cref="Trim"/> reaches all of them
+	/// </remarks>
+	class MemoryPressure
+	{
+	public:
+		/// <summary>
+		/// Adds a function that releases reclaimable memory
+		/// </summary>
+		/// <param name="trim">The function</param>
+		/// <example>
+		/// MemoryPressure::Add([] { cache.Clear(); });
+		/// </example>
+		static void Add(const std::function<void()>& trim)
+		{
+			auto& state = Instance();
+			std::lock_guard<std::mutex> lock(state.Mutex);
+			state.Trims.push_back(trim);
+		}
+
+		/// <summary>
+		/// Releases reclaimable memory, by calling every function that was added
+		/// </summary>
+		/// <example>
+		/// MemoryPressure::Trim();
+		/// </example>
+		static void Trim()
+		{
+			std::vector<std::function<void()>> trims;
+
+			{
+				auto& state = Instance();
+				std::lock_guard<std::mutex> lock(state.Mutex);
+				trims = state.Trims;
+			}
+
+			for (auto& trim : trims)
+			{
+				trim();
+			}
+		}
+
+		/// <summary>
+		/// Reads a pressure file, such as <c>/proc/pressure/memory</c>, a cgroup's <c>memory.pressure</c> or a cgroup's <c>memory.current</c>
+		/// </summary>
+		/// <param name="path">The path of the file</param>
+		/// <returns>The <c>some avg10</c> percentage for pressure stall files, the value for single value files, or a negative number if the file can't be read</returns>
+		/// <example>
+		/// MemoryPressure::Read("/sys/fs/cgroup/memory.pressure");
+		/// </example>
+		static double Read(const std::string& path)
+		{
+			std::ifstream file(path);
+			std::string token;
+			if (!(file >> token))
+			{
+				return -1;
+			}
+
+			// pressure stall files start with "some avg10=1.23 avg60=..."
+			if (token == "some")
+			{
+				if (!(file >> token) || token.compare(0, 6, "avg10=") != 0)
+				{
+					return -1;
+				}
+
+				token = token.substr(6);
+			}
+
+			try
+			{
+				return std::stod(token);
+			}
+			catch (const std::exception&)
+			{
+				return -1;
+			}
+		}
+
+		/// <summary>
+		/// Starts a background thread that reads a pressure file every <c>interval</c>, and calls <see cref="Trim"/> whenever
+		/// the value read reaches <c>threshold</c>. Replaces any earlier watch
+		/// </summary>
+		/// <param name="path">The path of the file, see <see cref="Read"/></param>
+		/// <param name="threshold">The value at which to trim, for instance 10 (percent) for <c>memory.pressure</c>, or a byte count for <c>memory.current</c></param>
+		/// <param name="interval">How often to read the file</param>
+		/// <example>
+		/// MemoryPressure::Watch("/sys/fs/cgroup/memory.pressure", 10);
+		/// </example>
+		static void Watch(const std::string& path, double threshold, std::chrono::milliseconds interval = std::chrono::seconds(1))
+		{
+			Unwatch();
+
+			auto& state = Instance();
+			std::lock_guard<std::mutex> lock(state.Mutex);
+			state.Stop = false;
+			state.Watcher = std::thread([path, threshold, interval] {
+				auto& state = Instance();
+				std::unique_lock<std::mutex> lock(state.Mutex);
+
+				while (!state.Wake.wait_for(lock, interval, [&] { return state.Stop; }))
+				{
+					lock.unlock();
+
+					if (Read(path) >= threshold)
+					{
+						Trim();
+					}
+
+					lock.lock();
+				}
+			});
+		}
+
+		/// <summary>
+		/// Stops the background thread started by <see cref="Watch"/>, if there is one
+		/// </summary>
+		/// <example>
+		/// MemoryPressure::Unwatch();
+		/// </example>
+		static void Unwatch()
+		{
+			auto& state = Instance();
+			std::thread watcher;
+
+			{
+				std::lock_guard<std::mutex> lock(state.Mutex);
+				state.Stop = true;
+				state.Wake.notify_all();
+				watcher.swap(state.Watcher);
+			}
+
+			if (watcher.joinable())
+			{
+				watcher.join();
+			}
+		}
+
+	private:
+		struct State
+		{
+			State() : Stop(false)
+			{
+			}
+
+			~State()
+			{
+				{
+					std::lock_guard<std::mutex> lock(Mutex);
+					Stop = true;
+					Wake.notify_all();
+				}
+
+				if (Watcher.joinable())
+				{
+					Watcher.join();
+				}
+			}
+
+			std::mutex Mutex;
+			std::condition_variable Wake;
+			std::vector<std::function<void()>> Trims;
+			bool Stop;
+			std::thread Watcher;
+		};
+
+		static State& Instance()
+		{
+			static State state;
+			return state;
+		}
+	};
+
+	/// <summary>
+	/// Represents an object that isn't gotten until it is first used
+	/// </summary>
+	/// <remarks>
+	/// Safe to use from multiple threads. Copies share the same object, which is gotten at most once, unless getting it throws
+	/// </remarks>
+	/// <param name="TObject">The type of object</param>
+	template <class TObject>
+	class Lazy
+	{
+	public:
+		/// <summary>
+		/// The type of a function that gets the object
+		/// </summary>
+		typedef std::function<std::shared_ptr<TObject>()> GetFuncType;
+
+		/// <summary>
+		/// Creates a handle that calls <c>get</c> on first use
+		/// </summary>
+		/// <param name="get">Function that gets the object</param>
+		explicit Lazy(const GetFuncType& get) : m_state(std::make_shared<State>(get))
+		{
+		}
+
+		/// <summary>
+		/// Gets the object, getting it first if needed
+		/// </summary>
+		/// <returns>The object</returns>
+		std::shared_ptr<TObject> Get() const
+		{
+			return Ensure();
+		}
+
+		/// <summary>
+		/// Determines if the object has been gotten yet
+		/// </summary>
+		/// <returns>true if gotten</returns>
+		bool IsValueCreated() const
+		{
+			return m_state->Created.load(std::memory_order_acquire);
+		}
+
+		TObject& operator*() const
+		{
+			return *Ensure();
+		}
+
+		TObject* operator->() const
+		{
+			return Ensure().get();
+		}
+
+	private:
+		/// <summary>
+		/// Gets the object first if needed
+		/// </summary>
+		/// <returns>The shared object, which the dereference operators use without copying it</returns>
+		const std::shared_ptr<TObject>& Ensure() const
+		{
+			// once created, this is a single load
+			if (!m_state->Created.load(std::memory_order_acquire))
+			{
+				std::call_once(m_state->Once, [this] {
+					m_state->Value = m_state->Func();
+					m_state->Func = nullptr;
+					m_state->Created.store(true, std::memory_order_release);
+				});
+			}
+
+			return m_state->Value;
+		}
+
+		/// <summary>
+		/// The state shared by copies of a handle
+		/// </summary>
+		struct State
+		{
+			State(const GetFuncType& func) : Func(func), Created(false)
+			{
+			}
+
+			std::once_flag Once;
+			GetFuncType Func;
+			std::shared_ptr<TObject> Value;
+			std::atomic<bool> Created;
+		};
+
+		std::shared_ptr<State> m_state;
+	};
+
+	/// <summary>
+	/// Determines if auto-wired constructors are given the <see cref="GlobalObject"/> for a dependency (the default), or a new <see cref="Object"/>
+	/// </summary>
+	/// <param name="TObject">The type of dependency</param>
+	/// <example>
+	/// template &lt;&gt; struct SharedDependency&lt;TObject&gt; : std::false_type {};
+	/// </example>
+	template <class TObject>
+	struct SharedDependency : std::true_type
+	{
+	};
+
+	/// <summary>
+	/// Determines the type <see cref="Object"/> constructs for a type (itself, by default) when no allocator is registered, binding
+	/// an interface to its implementation at compile time
+	/// </summary>
+	/// <param name="TObject">The type of object</param>
+	/// <param name="TZone">The zone the binding applies to</param>
+	/// <example>
+	/// template &lt;int TZone&gt; struct Implementation&lt;TInterface, TZone&gt; { typedef TImplementation type; };
+	/// </example>
+	template <class TObject, int TZone = 0>
+	struct Implementation
+	{
+		typedef TObject type;
+	};
+
+	/// <summary>
+	/// Declares the allocator for a type and zone at compile time, by specializing with a static <c>Allocate</c> function. Nothing is
+	/// registered or initialized at runtime, and <see cref="Object::Get"/> calls the function directly
+	/// </summary>
+	/// <remarks>
+	/// A declared allocator takes the place of the zone's registrations, so allocators registered at runtime, fallbacks and decorators
+	/// don't apply to it. Thread-local overrides (see <see cref="Object::Override"/>) still do
+	/// </remarks>
+	/// <param name="TObject">The type of object</param>
+	/// <param name="TZone">The zone</param>
+	/// <example>
+	/// template &lt;&gt; struct StaticAllocator&lt;TObject, 1&gt; { static std::shared_ptr&lt;TObject&gt; Allocate() { return std::make_shared&lt;TObject&gt;(); } };
+	/// </example>
+	template <class TObject, int TZone = 0>
+	struct StaticAllocator
+	{
+	};
+
+	/// <summary>
+	/// Identifies the <see cref="GlobalObject"/> for a particular type and zone
+	/// </summary>
+	struct GlobalKey
+	{
+		GlobalKey(const std::type_index& type, int zone) : Type(type), Zone(zone)
+		{
+		}
+
+		bool operator<(const GlobalKey& other) const
+		{
+			return Type < other.Type || (Type == other.Type && Zone < other.Zone);
+		}
+
+		bool operator==(const GlobalKey& other) const
+		{
+			return Type == other.Type && Zone == other.Zone;
+		}
+
+		/// <summary>
+		/// The type of object
+		/// </summary>
+		std::type_index Type;
+
+		/// <summary>
+		/// The zone
+		/// </summary>
+		int Zone;
+	};
+
+	/// <summary>
+	/// Tracks the thread-local overrides (see <see cref="Object::Override"/> and <see cref="GlobalObject::Override"/>) that are active,
+	/// so that gets only look for one while some thread has one
+	/// </summary>
+	class Overrides
+	{
+	public:
+		/// <summary>
+		/// Stops overrides from applying on the calling thread, such as while allocating an object that is shared with other threads
+		/// </summary>
+		class Suppression
+		{
+		public:
+			Suppression()
+			{
+				++Suppressed();
+			}
+
+			~Suppression()
+			{
+				--Suppressed();
+			}
+
+			Suppression(const Suppression&) = delete;
+			Suppression& operator=(const Suppression&) = delete;
+		};
+
+		/// <summary>
+		/// Determines if overrides may apply on the calling thread. When no thread has one, this is a single relaxed load
+		/// </summary>
+		/// <returns>true if the calling thread has an override, and hasn't suppressed them</returns>
+		static bool IsActive()
+		{
+			return Count().load(std::memory_order_relaxed) != 0 && Local() != 0 && Suppressed() == 0;
+		}
+
+		/// <summary>
+		/// Records that the calling thread has installed an override
+		/// </summary>
+		static void Add()
+		{
+			++Local();
+			Count().fetch_add(1);
+		}
+
+		/// <summary>
+		/// Records that the calling thread has removed an override
+		/// </summary>
+		static void Remove()
+		{
+			--Local();
+			Count().fetch_sub(1);
+		}
+
+	private:
+		friend class CoroutineContext;
+
+		static std::atomic<size_t>& Count()
+		{
+			static std::atomic<size_t> count(0);
+			return count;
+		}
+
+		static size_t& Local()
+		{
+			static thread_local size_t local = 0;
+			return local;
+		}
+
+		static size_t& Suppressed()
+		{
+			static thread_local size_t suppressed = 0;
+			return suppressed;
+		}
+	};
+
+	/// <summary>
+	/// The steps that build an auto-wired object and its dependencies, in dependency order, recorded the first time the object is
+	/// built so that later builds replay them rather than getting each dependency through its own <c>Get</c>
+	/// </summary>
+	/// <remarks>
+	/// Plans are immutable once recorded, and are invalidated whenever any allocator registration changes
+	/// </remarks>
+	class ConstructionPlan
+	{
+	public:
+		/// <summary>
+		/// The type of a step, which builds an object from the objects built by earlier steps
+		/// </summary>
+		/// <param name="built">The objects built so far, one per step</param>
+		/// <param name="arguments">The steps whose objects are passed to the constructor</param>
+		typedef std::shared_ptr<void>(*StepFuncType)(const std::shared_ptr<void>* built, const size_t* arguments);
+
+		/// <summary>
+		/// Converts to a <c>std::shared_ptr</c> for any type by casting the object built by an earlier step, so that replayed
+		/// steps call the same constructors that were auto-wired
+		/// </summary>
+		struct Argument
+		{
+			explicit Argument(const std::shared_ptr<void>* value) : Value(value)
+			{
+			}
+
+			template <class TObject>
+			operator std::shared_ptr<TObject>() const
+			{
+				return std::static_pointer_cast<TObject>(*Value);
+			}
+
+			const std::shared_ptr<void>* Value;
+		};
+
+		/// <summary>
+		/// Marks the calling thread as building an object, throwing if it is already building it (which would never finish)
+		/// </summary>
+		class Scope
+		{
+		public:
+			/// <param name="key">The type and zone being built</param>
+			/// <param name="global">true if building the <see cref="GlobalObject"/>, rather than an <see cref="Object"/></param>
+			/// <exception cref="std::logic_error">The calling thread is already building the object</exception>
+			Scope(const GlobalKey& key, bool global)
+			{
+				Check(key, global);
+				Building().push_back(Frame{ key, global });
+			}
+
+			~Scope()
+			{
+				Building().pop_back();
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		};
+
+		/// <summary>
+		/// Starts recording a plan against the current registrations
+		/// </summary>
+		ConstructionPlan() : m_generation(Generation().load())
+		{
+		}
+
+		/// <summary>
+		/// Adds a step that builds an object from the objects of earlier steps
+		/// </summary>
+		/// <param name="step">Function that builds the object</param>
+		/// <param name="arguments">The steps whose objects are passed to the constructor</param>
+		/// <param name="count">How many arguments there are</param>
+		/// <returns>The index of the step</returns>
+		size_t Add(StepFuncType step, const size_t* arguments, size_t count)
+		{
+			m_steps.push_back(Step{ step, m_arguments.size() });
+			m_arguments.insert(m_arguments.end(), arguments, arguments + count);
+
+			return m_steps.size() - 1;
+		}
+
+		/// <summary>
+		/// Adds a step that gets a <see cref="GlobalObject"/>, unless the plan already gets it
+		/// </summary>
+		/// <param name="key">The type and zone of the global</param>
+		/// <param name="step">Function that gets the global</param>
+		/// <returns>The index of the step</returns>
+		size_t AddGlobal(const GlobalKey& key, StepFuncType step)
+		{
+			auto found = m_globals.find(key);
+			if (found != m_globals.end())
+			{
+				return found->second;
+			}
+
+			auto index = Add(step, nullptr, 0);
+			m_globals.insert(std::make_pair(key, index));
+
+			return index;
+		}
+
+		/// <summary>
+		/// Determines if the plan was recorded against the current registrations
+		/// </summary>
+		/// <returns>true if current</returns>
+		bool IsCurrent() const
+		{
+			return m_generation == Generation().load();
+		}
+
+		/// <summary>
+		/// Runs each step in order
+		/// </summary>
+		/// <returns>The object built by the last step</returns>
+		std::shared_ptr<void> Run() const
+		{
+			std::vector<std::shared_ptr<void>> built(m_steps.size());
+
+			for (size_t i = 0; i < m_steps.size(); ++i)
+			{
+				built[i] = m_steps[i].Func(built.data(), m_arguments.data() + m_steps[i].First);
+			}
+
+			return built.back();
+		}
+
+		/// <summary>
+		/// Invalidates every plan, called when allocator registrations change
+		/// </summary>
+		static void Invalidate()
+		{
+			Generation().fetch_add(1);
+		}
+
+		/// <summary>
+		/// Throws if the calling thread is already building an object
+		/// </summary>
+		/// <param name="key">The type and zone being built</param>
+		/// <param name="global">true if building the <see cref="GlobalObject"/>, rather than an <see cref="Object"/></param>
+		/// <exception cref="std::logic_error">The calling thread is already building the object</exception>
+		static void Check(const GlobalKey& key, bool global)
+		{
+			auto& building = Building();
+
+			auto cycle = std::find_if(building.begin(), building.end(), [&](const Frame& frame) { return frame.Key == key && frame.Global == global; });
+			if (cycle == building.end())
+			{
+				return;
+			}
+
+			std::vector<GlobalKey> path;
+			for (auto frame = cycle; frame != building.end(); ++frame)
+			{
+				path.push_back(frame->Key);
+			}
+			path.push_back(key);
+
+			// a global and the object it allocates share a key, so only name it once
+			std::string message = "dependency cycle: ";
+			for (size_t i = 0; i < path.size(); ++i)
+			{
+				if (i == 0 || !(path[i] == path[i - 1]))
+				{
+					message += (i == 0 ? "" : " -> ") + std::string(path[i].Type.name()) + " zone " + std::to_string(path[i].Zone);
+				}
+			}
+
+			throw std::logic_error(message);
+		}
+
+	private:
+		friend class CoroutineContext;
+
+		/// <summary>
+		/// A step, and where its arguments start
+		/// </summary>
+		struct Step
+		{
+			StepFuncType Func;
+			size_t First;
+		};
+
+		/// <summary>
+		/// An object the calling thread is building
+		/// </summary>
+		struct Frame
+		{
+			GlobalKey Key;
+			bool Global;
+		};
+
+		/// <summary>
+		/// Changes whenever allocator registrations change
+		/// </summary>
+		static std::atomic<uint64_t>& Generation()
+		{
+			static std::atomic<uint64_t> generation(0);
+			return generation;
+		}
+
+		/// <summary>
+		/// The objects the calling thread is building, outermost first
+		/// </summary>
+		static std::vector<Frame>& Building()
+		{
+			static thread_local std::vector<Frame> building;
+			return building;
+		}
+
+		std::vector<Step> m_steps;
+		std::vector<size_t> m_arguments;
+		std::map<GlobalKey, size_t> m_globals;
+		uint64_t m_generation;
+	};
+
+	/// <summary>
+	/// Converts to a <c>std::shared_ptr</c> for any type by getting it from the same zone, so that <see cref="Object"/> can call
+	/// constructors that take dependencies without naming them. Each dependency is recorded as a step of a <see cref="ConstructionPlan"/>
+	/// </summary>
+	/// <param name="TZone">The zone to get dependencies from</param>
+	template <int TZone>
+	struct AutoWire
+	{
+		/// <summary>
+		/// Creates a dependency that is only used to find constructors
+		/// </summary>
+		AutoWire() : m_plan(nullptr), m_step(nullptr)
+		{
+		}
+
+		/// <param name="plan">The plan to record the dependency in</param>
+		/// <param name="step">Set to the step that builds the dependency</param>
+		AutoWire(ConstructionPlan* plan, size_t* step) : m_plan(plan), m_step(step)
+		{
+		}
+
+		template <class TDependency>
+		operator std::shared_ptr<TDependency>() const;
+
+	private:
+		ConstructionPlan* m_plan;
+		size_t* m_step;
+	};
+
+	/// <summary>
+	/// Tracks the <see cref="GlobalObject"/> types that are in use, the globals that have been registered for initialization
+	/// via <see cref="GlobalObject::Register"/>, and the dependencies between them
+	/// </summary>
+	class GlobalRegistry
+	{
+	public:
+		/// <summary>
+		/// A global that should be initialized, along with the globals it depends on
+		/// </summary>
+		struct Registration
+		{
+			GlobalKey Key;
+			std::vector<GlobalKey> Dependencies;
+			std::function<void()> Initialize;
+		};
+
+		/// <summary>
+		/// A <see cref="GlobalObject"/> type that has cached objects, along with how to tear them down
+		/// </summary>
+		struct Type
+		{
+			std::type_index Id;
+			std::function<void()> Teardown;
+		};
+
+		/// <summary>
+		/// Marks the calling thread as allocating a global of a particular type, so the globals it uses can be recorded as its dependencies
+		/// </summary>
+		class AllocationScope
+		{
+		public:
+			explicit AllocationScope(const std::type_index& type)
+			{
+				Allocating().push_back(type);
+			}
+
+			~AllocationScope()
+			{
+				Allocating().pop_back();
+			}
+
+			AllocationScope(const AllocationScope&) = delete;
+			AllocationScope& operator=(const AllocationScope&) = delete;
+		};
+
+		/// <summary>
+		/// Adds (or replaces) a registration
+		/// </summary>
+		/// <param name="registration">The registration</param>
+		static void Add(const Registration& registration)
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+			Map().erase(registration.Key);
+			Map().insert(std::make_pair(registration.Key, registration));
+		}
+
+		/// <summary>
+		/// Removes a registration
+		/// </summary>
+		/// <param name="key">The global to remove</param>
+		static void Remove(const GlobalKey& key)
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+			Map().erase(key);
+		}
+
+		/// <summary>
+		/// Gets a copy of all registrations
+		/// </summary>
+		/// <returns>The registrations</returns>
+		static std::vector<Registration> Registrations()
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+
+			std::vector<Registration> registrations;
+			for (auto& registration : Map())
+			{
+				registrations.push_back(registration.second);
+			}
+
+			return registrations;
+		}
+
+		/// <summary>
+		/// Adds a type that has cached objects, if it hasn't already been added
+		/// </summary>
+		/// <param name="type">The type</param>
+		static void AddType(const Type& type)
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+			Types().insert(std::make_pair(type.Id, type));
+		}
+
+		/// <summary>
+		/// Gets a copy of all types that have cached objects
+		/// </summary>
+		/// <returns>The types</returns>
+		static std::vector<Type> AllTypes()
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+
+			std::vector<Type> types;
+			for (auto& type : Types())
+			{
+				types.push_back(type.second);
+			}
+
+			return types;
+		}
+
+		/// <summary>
+		/// Records that a global of a particular type is being used, which makes it a dependency of whatever type the calling thread is allocating
+		/// </summary>
+		/// <param name="type">The type being used</param>
+		static void Use(const std::type_index& type)
+		{
+			auto& allocating = Allocating();
+			if (allocating.empty() || allocating.back() == type)
+			{
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(Mutex());
+			TypeDependencies().insert(std::make_pair(allocating.back(), type));
+		}
+
+		/// <summary>
+		/// Gets the dependencies between types, both registered and recorded while allocating
+		/// </summary>
+		/// <returns>Pairs of (dependent, dependency)</returns>
+		static std::vector<std::pair<std::type_index, std::type_index>> TypeDependencyList()
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+
+			std::set<std::pair<std::type_index, std::type_index>> dependencies = TypeDependencies();
+			for (auto& registration : Map())
+			{
+				for (auto& dependency : registration.second.Dependencies)
+				{
+					if (registration.first.Type != dependency.Type)
+					{
+						dependencies.insert(std::make_pair(registration.first.Type, dependency.Type));
+					}
+				}
+			}
+
+			return std::vector<std::pair<std::type_index, std::type_index>>(dependencies.begin(), dependencies.end());
+		}
+
+		/// <summary>
+		/// Runs work for each node of a dependency graph concurrently on the <see cref="Executor"/>, starting each node as soon as the nodes
+		/// it waits for are done, and blocking until every node is done
+		/// </summary>
+		/// <remarks>
+		/// If work throws, nodes that wait for it are skipped and the first exception is rethrown once running work finishes
+		/// </remarks>
+		/// <param name="count">The number of nodes</param>
+		/// <param name="unblocks">For each node, the nodes that wait for it</param>
+		/// <param name="work">The work for a node</param>
+		/// <returns>The index of a node in a cycle (in which case nothing was run), or <c>count</c></returns>
+		static size_t Run(size_t count, const std::vector<std::vector<size_t>>& unblocks, const std::function<void(size_t)>& work)
+		{
+			struct State
+			{
+				std::vector<std::vector<size_t>> Unblocks;
+				std::vector<size_t> Blockers;
+				std::function<void(size_t)> Work;
+				std::exception_ptr Error;
+				size_t Running = 0;
+				std::function<void(size_t)> Start;
+				std::mutex Mutex;
+				std::condition_variable Finished;
+			};
+
+			auto state = std::make_shared<State>();
+			state->Unblocks = unblocks;
+			state->Work = work;
+			state->Blockers.resize(count);
+
+			for (auto& waiting : unblocks)
+			{
+				for (auto node : waiting)
+				{
+					++state->Blockers[node];
+				}
+			}
+
+			// find cycles up front, rather than starting work we can't finish
+			std::vector<size_t> ready;
+			{
+				auto blockers = state->Blockers;
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (blockers[i] == 0)
+					{
+						ready.push_back(i);
+					}
+				}
+
+				std::vector<size_t> order = ready;
+				for (size_t next = 0; next < order.size(); ++next)
+				{
+					for (auto node : unblocks[order[next]])
+					{
+						if (--blockers[node] == 0)
+						{
+							order.push_back(node);
+						}
+					}
+				}
+
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (blockers[i] != 0)
+					{
+						return i;
+					}
+				}
+			}
+
+			// runs a node (on the executor), then starts whichever nodes it unblocked
+			std::weak_ptr<State> weakState = state;
+			state->Start = [weakState](size_t i) {
+				Executor::Execute([weakState, i] {
+					auto state = weakState.lock();
+					std::exception_ptr error;
+
+					try
+					{
+						state->Work(i);
+					}
+					catch (...)
+					{
+						error = std::current_exception();
+					}
+
+					std::vector<size_t> unblocked;
+					{
+						std::lock_guard<std::mutex> lock(state->Mutex);
+
+						if (error)
+						{
+							if (!state->Error)
+							{
+								state->Error = error;
+							}
+						}
+						else
+						{
+							for (auto node : state->Unblocks[i])
+							{
+								if (--state->Blockers[node] == 0)
+								{
+									unblocked.push_back(node);
+								}
+							}
+						}
+
+						state->Running += unblocked.size();
+					}
+
+					for (auto node : unblocked)
+					{
+						state->Start(node);
+					}
+
+					std::lock_guard<std::mutex> lock(state->Mutex);
+					if (--state->Running == 0)
+					{
+						state->Finished.notify_all();
+					}
+				});
+			};
+
+			{
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				state->Running = ready.size();
+			}
+
+			for (auto i : ready)
+			{
+				state->Start(i);
+			}
+
+			std::unique_lock<std::mutex> lock(state->Mutex);
+			state->Finished.wait(lock, [&] { return state->Running == 0; });
+
+			if (state->Error)
+			{
+				std::rethrow_exception(state->Error);
+			}
+
+			return count;
+		}
+
+	private:
+		friend class CoroutineContext;
+
+		static std::mutex& Mutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		static std::map<GlobalKey, Registration>& Map()
+		{
+			static std::map<GlobalKey, Registration> map;
+			return map;
+		}
+
+		static std::map<std::type_index, Type>& Types()
+		{
+			static std::map<std::type_index, Type> types;
+			return types;
+		}
+
+		static std::set<std::pair<std::type_index, std::type_index>>& TypeDependencies()
+		{
+			static std::set<std::pair<std::type_index, std::type_index>> dependencies;
+			return dependencies;
+		}
+
+		static std::vector<std::type_index>& Allocating()
+		{
+			static thread_local std::vector<std::type_index> allocating;
+			return allocating;
+		}
+	};
+
+	/// <summary>
+	/// How long a single global took to initialize
+	/// </summary>
+	struct InitializeTiming
+	{
+		GlobalKey Key;
+		std::chrono::nanoseconds Duration;
+	};
+
+	/// <summary>
+	/// Initializes every registered <see cref="GlobalObject"/> concurrently on the <see cref="Executor"/>, starting each one
+	/// as soon as the globals it depends on are ready
+	/// </summary>
+	/// <remarks>
+	/// Blocks until every global is initialized. Dependencies on globals that are not registered are ignored. If an allocator throws,
+	/// globals that depend on it are skipped and the first exception is rethrown once running work finishes
+	/// </remarks>
+	/// <returns>How long each global took to initialize, in the order they finished</returns>
+	/// <exception cref="std::logic_error">The registered dependencies contain a cycle</exception>
+	/// <example>
+	/// auto timings = InitializeAll();
+	/// </example>
+	inline std::vector<InitializeTiming> InitializeAll()
+	{
+		auto registrations = GlobalRegistry::Registrations();
+		auto count = registrations.size();
+
+		std::map<GlobalKey, size_t> index;
+		for (size_t i = 0; i < count; ++i)
+		{
+			index.insert(std::make_pair(registrations[i].Key, i));
+		}
+
+		// a global unblocks the globals that depend on it
+		std::vector<std::vector<size_t>> unblocks(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (auto& dependency : registrations[i].Dependencies)
+			{
+				auto found = index.find(dependency);
+				if (found != index.end())
+				{
+					unblocks[found->second].push_back(i);
+				}
+			}
+		}
+
+		std::mutex mutex;
+		std::vector<InitializeTiming> timings;
+
+		auto cycle = GlobalRegistry::Run(count, unblocks, [&](size_t i) {
+			auto start = std::chrono::steady_clock::now();
+			registrations[i].Initialize();
+			auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			timings.push_back(InitializeTiming{ registrations[i].Key, duration });
+		});
+
+		if (cycle != count)
+		{
+			throw std::logic_error(std::string("dependency cycle between registered globals, involving ") +
+				registrations[cycle].Key.Type.name() + " zone " + std::to_string(registrations[cycle].Key.Zone));
+		}
+
+		return timings;
+	}
+
+	/// <summary>
+	/// Resets every <see cref="GlobalObject"/> type that has cached objects, and destroys the cleared objects
+	/// </summary>
+	/// <remarks>
+	/// Types are torn down concurrently on the <see cref="Executor"/>, each one only after the types that depend on it. Dependencies are
+	/// those registered via <see cref="GlobalObject::Register"/>, along with those recorded when one global's allocator uses another.
+	/// If the dependencies contain a cycle, every type is torn down one at a time instead
+	/// </remarks>
+	/// <example>
+	/// ResetAll();
+	/// </example>
+	inline void ResetAll()
+	{
+		auto types = GlobalRegistry::AllTypes();
+		auto count = types.size();
+
+		std::map<std::type_index, size_t> index;
+		for (size_t i = 0; i < count; ++i)
+		{
+			index.insert(std::make_pair(types[i].Id, i));
+		}
+
+		// a type unblocks the types it depends on, since dependents go first
+		std::vector<std::vector<size_t>> unblocks(count);
+		for (auto& dependency : GlobalRegistry::TypeDependencyList())
+		{
+			auto dependent = index.find(dependency.first);
+			auto dependee = index.find(dependency.second);
+			if (dependent != index.end() && dependee != index.end())
+			{
+				unblocks[dependent->second].push_back(dependee->second);
+			}
+		}
+
+		auto cycle = GlobalRegistry::Run(count, unblocks, [&](size_t i) { types[i].Teardown(); });
+
+		if (cycle != count)
+		{
+			for (auto& type : types)
+			{
+				type.Teardown();
+			}
+		}
+	}
+
+	/// <summary>
+	/// Binds zones to allocators registered by name (via <see cref="Object::RegisterAllocator"/>), from configuration
+	/// </summary>
+	/// <remarks>
+	/// Configuration has one binding per line, as <c>zone = name</c>, which binds the zone of every type with an allocator of that
+	/// name. Blank lines, and anything after a <c>#</c>, are ignored. Once loaded, a bound zone is the same as one registered in code,
+	/// so gets involve no names
+	/// </remarks>
+	/// <example>
+	/// # zone 3 uses the pooled postgres backend
+	/// 3 = store.postgres
+	/// </example>
+	class Bindings
+	{
+	public:
+		/// <summary>
+		/// The type of a function that binds a zone to a named allocator
+		/// </summary>
+		typedef std::function<void(int)> BindFuncType;
+
+		/// <summary>
+		/// Adds (or replaces) the allocator of a type with a name
+		/// </summary>
+		/// <param name="type">The type the allocator allocates</param>
+		/// <param name="name">The name</param>
+		/// <param name="bind">Function that binds a zone to the allocator</param>
+		static void Add(const std::type_index& type, const std::string& name, const BindFuncType& bind)
+		{
+			std::lock_guard<std::mutex> lock(Mutex());
+			Map()[name][type] = bind;
+		}
+
+		/// <summary>
+		/// Binds zones as configured in a file
+		/// </summary>
+		/// <param name="path">The path of the file</param>
+		/// <exception cref="std::runtime_error">The file can't be read</exception>
+		/// <exception cref="std::invalid_argument">A line is malformed or names an allocator that isn't registered, in which case nothing is bound</exception>
+		static void Load(const std::string& path)
+		{
+			std::ifstream file(path);
+			if (!file)
+			{
+				throw std::runtime_error("unable to read bindings from " + path);
+			}
+
+			Load(file);
+		}
+
+		/// <summary>
+		/// Binds zones as configured in a stream
+		/// </summary>
+		/// <param name="config">The configuration</param>
+		/// <exception cref="std::invalid_argument">A line is malformed or names an allocator that isn't registered, in which case nothing is bound</exception>
+		static void Load(std::istream& config)
+		{
+			std::vector<std::pair<int, BindFuncType>> bindings;
+
+			{
+				std::lock_guard<std::mutex> lock(Mutex());
+
+				std::string line;
+				for (size_t number = 1; std::getline(config, line); ++number)
+				{
+					line = Trim(line.substr(0, line.find('#')));
+					if (line.empty())
+					{
+						continue;
+					}
+
+					auto separator = line.find('=');
+					auto zone = Trim(line.substr(0, separator == std::string::npos ? 0 : separator));
+					auto name = Trim(separator == std::string::npos ? std::string() : line.substr(separator + 1));
+
+					size_t parsed = 0;
+					int value = 0;
+					try
+					{
+						value = std::stoi(zone, &parsed);
+					}
+					catch (const std::exception&)
+					{
+					}
+
+					if (name.empty() || zone.empty() || parsed != zone.size())
+					{
+						throw std::invalid_argument("bindings line " + std::to_string(number) + ": expected 'zone = name'");
+					}
+
+					auto found = Map().find(name);
+					if (found == Map().end())
+					{
+						throw std::invalid_argument("bindings line " + std::to_string(number) + ": no allocator named '" + name + "'");
+					}
+
+					for (auto& bind : found->second)
+					{
+						bindings.push_back(std::make_pair(value, bind.second));
+					}
+				}
+			}
+
+			// bound outside the lock, since binding takes each type's own lock
+			for (auto& binding : bindings)
+			{
+				binding.second(binding.first);
+			}
+		}
+
+	private:
+		/// <summary>
+		/// Removes leading and trailing whitespace
+		/// </summary>
+		static std::string Trim(const std::string& value)
+		{
+			auto first = value.find_first_not_of(" \t\r");
+			auto last = value.find_last_not_of(" \t\r");
+
+			return first == std::string::npos ? std::string() : value.substr(first, last - first + 1);
+		}
+
+		static std::mutex& Mutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+		/// <summary>
+		/// Gets the allocators registered with each name, by type
+		/// </summary>
+		static std::map<std::string, std::map<std::type_index, BindFuncType>>& Map()
+		{
+			static std::map<std::string, std::map<std::type_index, BindFuncType>> map;
+			return map;
+		}
+	};
+
+#ifdef CPPFACTORY_COROUTINES
+	/// <summary>
+	/// Carries the thread-local state of the allocations a <see cref="Task"/> is in the middle of (suppressed overrides, and the globals
+	/// and objects being built) across its suspensions, so that the state follows the task to whichever thread resumes it
+	/// </summary>
+	/// <remarks>
+	/// Tasks awaited by tasks share their awaiter's state. Other awaitables are wrapped, so that the state the tasks added is taken off
+	/// the thread when they suspend, and put back on the thread that resumes them
+	/// </remarks>
+	class CoroutineContext
+	{
+	public:
+		/// <summary>
+		/// The base of the promises of coroutines that carry their state
+		/// </summary>
+		struct Promise
+		{
+		};
+
+		/// <summary>
+		/// The state a coroutine took with it when it suspended
+		/// </summary>
+		struct Saved
+		{
+			Saved() : Suppressed(0)
+			{
+			}
+
+			size_t Suppressed;
+			std::vector<std::type_index> Allocating;
+			std::vector<ConstructionPlan::Frame> Building;
+		};
+
+		/// <summary>
+		/// Wraps an awaitable so that the state is carried across it
+		/// </summary>
+		template <class TAwaitable>
+		class Awaiter
+		{
+		public:
+			explicit Awaiter(TAwaitable&& awaitable) : m_awaitable(std::forward<TAwaitable>(awaitable)), m_left(false)
+			{
+			}
+
+			bool await_ready()
+			{
+				return m_awaitable.await_ready();
+			}
+
+			template <class TPromise>
+			auto await_suspend(std::coroutine_handle<TPromise> handle)
+			{
+				// once the awaitable has the handle, we may be resumed (on any thread) at any time
+				m_saved = Leave();
+				m_left = true;
+
+				try
+				{
+					return m_awaitable.await_suspend(handle);
+				}
+				catch (...)
+				{
+					Resume();
+					throw;
+				}
+			}
+
+			decltype(auto) await_resume()
+			{
+				Resume();
+				return m_awaitable.await_resume();
+			}
+
+		private:
+			void Resume()
+			{
+				if (m_left)
+				{
+					m_left = false;
+					Enter(m_saved);
+				}
+			}
+
+			TAwaitable m_awaitable;
+			Saved m_saved;
+			bool m_left;
+		};
+
+		/// <summary>
+		/// Marks the calling thread as running a coroutine, which adds state from here on
+		/// </summary>
+		static void Enter()
+		{
+			Bases().push_back(Depth{ Overrides::Suppressed(), GlobalRegistry::Allocating().size(), ConstructionPlan::Building().size() });
+		}
+
+		/// <summary>
+		/// Marks the calling thread as running a coroutine, putting back the state it took when it suspended
+		/// </summary>
+		/// <param name="saved">The state the coroutine took</param>
+		static void Enter(const Saved& saved)
+		{
+			Enter();
+
+			Overrides::Suppressed() += saved.Suppressed;
+			GlobalRegistry::Allocating().insert(GlobalRegistry::Allocating().end(), saved.Allocating.begin(), saved.Allocating.end());
+			ConstructionPlan::Building().insert(ConstructionPlan::Building().end(), saved.Building.begin(), saved.Building.end());
+		}
+
+		/// <summary>
+		/// Marks the calling thread as no longer running a coroutine, taking the state it added
+		/// </summary>
+		/// <returns>The state the coroutine added</returns>
+		static Saved Leave()
+		{
+			auto base = Bases().back();
+			Bases().pop_back();
+
+			auto& allocating = GlobalRegistry::Allocating();
+			auto& building = ConstructionPlan::Building();
+
+			Saved saved;
+			saved.Suppressed = Overrides::Suppressed() - base.Suppressed;
+			saved.Allocating.assign(allocating.begin() + base.Allocating, allocating.end());
+			saved.Building.assign(building.begin() + base.Building, building.end());
+
+			Overrides::Suppressed() = base.Suppressed;
+			allocating.erase(allocating.begin() + base.Allocating, allocating.end());
+			building.erase(building.begin() + base.Building, building.end());
+
+			return saved;
+		}
+
+	private:
+		/// <summary>
+		/// How much state the calling thread had when a coroutine started running on it
+		/// </summary>
+		struct Depth
+		{
+			size_t Suppressed;
+			size_t Allocating;
+			size_t Building;
+		};
+
+		static std::vector<Depth>& Bases()
+		{
+			static thread_local std::vector<Depth> bases;
+			return bases;
+		}
+	};
+
+	/// <summary>
+	/// Represents a lazily started coroutine that produces a <c>TResult</c>, and may be awaited once
+	/// </summary>
+	/// <remarks>
+	/// Only available when compiling with C++20 coroutine support
+	/// </remarks>
+	/// <param name="TResult">The type of result</param>
+	template <class TResult>
+	class Task
+	{
+	public:
+		class promise_type;
+
+		/// <summary>
+		/// Resumes whoever is awaiting the task once it finishes
+		/// </summary>
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				auto& promise = handle.promise();
+				if (promise.m_outermost)
+				{
+					CoroutineContext::Leave();
+				}
+
+				auto continuation = promise.m_continuation;
+				return continuation ? continuation : std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+		};
+
+		class promise_type : public CoroutineContext::Promise
+		{
+		public:
+			promise_type() : m_outermost(false)
+			{
+			}
+
+			Task get_return_object()
+			{
+				return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() const noexcept
+			{
+				return {};
+			}
+
+			FinalAwaiter final_suspend() const noexcept
+			{
+				return {};
+			}
+
+			template <class TValue>
+			void return_value(TValue&& value)
+			{
+				m_value.emplace(std::forward<TValue>(value));
+			}
+
+			void unhandled_exception()
+			{
+				m_error = std::current_exception();
+			}
+
+			template <class TValue>
+			Task<TValue>&& await_transform(Task<TValue>& task) const noexcept
+			{
+				return std::move(task);
+			}
+
+			template <class TValue>
+			Task<TValue>&& await_transform(Task<TValue>&& task) const noexcept
+			{
+				return std::move(task);
+			}
+
+			template <class TAwaitable>
+			decltype(auto) await_transform(TAwaitable&& awaitable) const
+			{
+				return Transform(std::forward<TAwaitable>(awaitable), IsAwaiter<TAwaitable>());
+			}
+
+		private:
+			friend class Task;
+
+			template <class TAwaitable, class = void>
+			struct IsAwaiter : std::false_type
+			{
+			};
+
+			template <class TAwaitable>
+			struct IsAwaiter<TAwaitable, decltype(std::declval<TAwaitable&>().await_ready(), void())> : std::true_type
+			{
+			};
+
+			template <class TAwaitable>
+			static CoroutineContext::Awaiter<TAwaitable> Transform(TAwaitable&& awaitable, std::true_type)
+			{
+				return CoroutineContext::Awaiter<TAwaitable>(std::forward<TAwaitable>(awaitable));
+			}
+
+			// awaitables with their own operator co_await can't be wrapped, so the state stays on the thread
+			template <class TAwaitable>
+			static TAwaitable&& Transform(TAwaitable&& awaitable, std::false_type)
+			{
+				return std::forward<TAwaitable>(awaitable);
+			}
+
+			bool m_outermost;
+			std::coroutine_handle<> m_continuation;
+			std::optional<TResult> m_value;
+			std::exception_ptr m_error;
+		};
+
+		Task(Task&& other) noexcept : m_handle(other.m_handle)
+		{
+			other.m_handle = nullptr;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+			}
+		}
+
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		template <class TPromise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> awaiting) noexcept
+		{
+			auto& promise = m_handle.promise();
+			promise.m_continuation = awaiting;
+
+			// a task awaited by something other than a task starts its own state
+			promise.m_outermost = !std::is_base_of<CoroutineContext::Promise, TPromise>::value;
+			if (promise.m_outermost)
+			{
+				CoroutineContext::Enter();
+			}
+
+			return m_handle;
+		}
+
+		TResult await_resume()
+		{
+			auto& promise = m_handle.promise();
+			if (promise.m_error)
+			{
+				std::rethrow_exception(promise.m_error);
+			}
+
+			return std::move(*promise.m_value);
+		}
+
+	private:
+		explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle)
+		{
+		}
+
+		std::coroutine_handle<promise_type> m_handle;
+	};
+
+	/// <summary>
+	/// Represents a coroutine that starts immediately and cleans up after itself, used to drive a <see cref="Task"/>
+	/// </summary>
+	struct DetachedTask
+	{
+		struct promise_type
+		{
+			DetachedTask get_return_object() const noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never initial_suspend() const noexcept
+			{
+				return {};
+			}
+
+			std::suspend_never final_suspend() const noexcept
+			{
+				return {};
+			}
+
+			void return_void() const noexcept
+			{
+			}
+
+			void unhandled_exception() const noexcept
+			{
+				std::terminate();
+			}
+		};
+	};
+
+	/// <summary>
+	/// Runs a <see cref="Task"/> to completion, blocking the calling thread until it finishes
+	/// </summary>
+	/// <param name="task">The task to run</param>
+	/// <returns>The result of the task</returns>
+	/// <example>
+	/// auto obj = SyncWait(Object&lt;TObject&gt;::CoGet());
+	/// </example>
+	template <class TResult>
+	TResult SyncWait(Task<TResult> task)
+	{
+		std::mutex mutex;
+		std::condition_variable finished;
+		bool done = false;
+		std::optional<TResult> value;
+		std::exception_ptr error;
+
+		auto drive = [&]() -> DetachedTask {
+			try
+			{
+				value.emplace(co_await std::move(task));
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			finished.notify_one();
+		};
+		drive();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [&] { return done; });
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+
+		return std::move(*value);
+	}
+
+	/// <summary>
+	/// Represents a minimal executor for coroutines: a queue of work that is run by whichever thread calls <c>Run</c>
+	/// </summary>
+	/// <example>
+	/// RunLoop loop;
+	/// auto obj = loop.Run(Object&lt;TObject&gt;::CoGet());
+	/// </example>
+	class RunLoop
+	{
+	public:
+		/// <summary>
+		/// Awaitable that continues the awaiting coroutine on the loop
+		/// </summary>
+		struct ScheduleAwaiter
+		{
+			RunLoop& Loop;
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			void await_suspend(std::coroutine_handle<> handle)
+			{
+				Loop.Post(handle);
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+		};
+
+		/// <summary>
+		/// Continues the awaiting coroutine on the loop
+		/// </summary>
+		/// <example>
+		/// co_await loop.Schedule();
+		/// </example>
+		ScheduleAwaiter Schedule()
+		{
+			return ScheduleAwaiter{ *this };
+		}
+
+		/// <summary>
+		/// Queues a coroutine to be resumed on the loop. Safe to call from any thread
+		/// </summary>
+		/// <param name="handle">The coroutine to resume</param>
+		void Post(std::coroutine_handle<> handle)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push_back(handle);
+			m_changed.notify_one();
+		}
+
+		/// <summary>
+		/// Runs queued work until there is none left
+		/// </summary>
+		void Run()
+		{
+			std::coroutine_handle<> handle;
+			while (Next(handle, false))
+			{
+				handle.resume();
+			}
+		}
+
+		/// <summary>
+		/// Runs a <see cref="Task"/> to completion, running queued work (and waiting for more) until it finishes
+		/// </summary>
+		/// <param name="task">The task to run</param>
+		/// <returns>The result of the task</returns>
+		template <class TResult>
+		TResult Run(Task<TResult> task)
+		{
+			bool done = false;
+			std::optional<TResult> value;
+			std::exception_ptr error;
+
+			auto drive = [&]() -> DetachedTask {
+				try
+				{
+					value.emplace(co_await std::move(task));
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				done = true;
+				m_changed.notify_one();
+			};
+			drive();
+
+			std::coroutine_handle<> handle;
+			while (Next(handle, true, &done))
+			{
+				handle.resume();
+			}
+
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+
+			return std::move(*value);
+		}
+
+	private:
+		/// <summary>
+		/// Takes the next piece of work, optionally waiting for some until <c>done</c> is set
+		/// </summary>
+		bool Next(std::coroutine_handle<>& handle, bool wait, const bool* done = nullptr)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (wait)
+			{
+				m_changed.wait(lock, [&] { return !m_queue.empty() || *done; });
+			}
+
+			if (m_queue.empty())
+			{
+				return false;
+			}
+
+			handle = m_queue.front();
+			m_queue.pop_front();
+			return true;
+		}
+
+		std::mutex m_mutex;
+		std::condition_variable m_changed;
+		std::deque<std::coroutine_handle<>> m_queue;
+	};
+#endif
+
+	/// <summary>
+	/// Represents an <see cref="Object"/> that has a global lifetime, meaning
+	/// it doesn't get destroyed when it leaves scope
+	/// </summary>
+	/// <remarks>
+	/// Safe to use from multiple threads. Concurrent requests for the same zone share a single allocation. Getting a cached object
+	/// takes no locks, and objects that are reset or replaced are destroyed once no concurrent <c>Get</c> can still see them (see <see cref="Epoch"/>)
+	/// </remarks>
+	/// <param name="TObject">The type of object</param>
+	template <class TObject>
+	class GlobalObject
+	{
+	public:
+		/// <summary>
+		/// Replaces the global object for a zone on the calling thread only, until destroyed. Overrides nest, and must be destroyed on
+		/// the thread that created them
+		/// </summary>
+		/// <remarks>
+		/// Applies to <see cref="Get"/>, <see cref="GetAsync"/> and <see cref="CoGet"/> on the calling thread, but not while allocating objects shared
+		/// with other threads, such as another global
+		/// </remarks>
+		/// <param name="TZone">The zone to override</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Override&lt;&gt; mock(std::make_shared&lt;TMock&gt;());
+		/// </example>
+		template <int TZone = 0>
+		class Override
+		{
+		public:
+			/// <param name="obj">The object</param>
+			explicit Override(const std::shared_ptr<TObject>& obj) : m_obj(obj), m_previous(Current())
+			{
+				Current() = this;
+				Overrides::Add();
+			}
+
+			~Override()
+			{
+				Current() = m_previous;
+				Overrides::Remove();
+			}
+
+			Override(const Override&) = delete;
+			Override& operator=(const Override&) = delete;
+
+		private:
+			friend class GlobalObject;
+
+			/// <summary>
+			/// The innermost override on the calling thread
+			/// </summary>
+			static Override*& Current()
+			{
+				static thread_local Override* current = nullptr;
+				return current;
+			}
+
+			std::shared_ptr<TObject> m_obj;
+			Override* m_previous;
+		};
+
+		/// <summary>
+		/// Gets (and allocates, if needed) a global object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Get();
+		/// </example>
+		template <int TZone = 0>
+		static std::shared_ptr<TObject> Get()
+		{
+			if (Overrides::IsActive())
+			{
+				auto current = Override<TZone>::Current();
+				if (current != nullptr)
+				{
+					return current->m_obj;
+				}
+			}
+
+			GlobalRegistry::Use(typeid(TObject));
+
+			std::shared_ptr<TObject> obj;
+			std::future<std::shared_ptr<TObject>> result;
+			bool refresh = false;
+			bool owner = false;
+
+			// the common case takes no locks
+			bool found = Find<TZone>(obj, refresh);
+			if (!found)
+			{
+				// waiting on our own allocation would never finish
+				ConstructionPlan::Check(Key<TZone>(), true);
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				// an allocation may have finished since we looked
+				found = Find<TZone>(obj, refresh);
+				if (!found)
+				{
+					result = Join<TZone>(CancellationToken(), std::chrono::steady_clock::time_point::max(), owner);
+				}
+			}
+
+			if (found)
+			{
+				if (refresh)
+				{
+					StartRefresh<TZone>();
+				}
+
+				return obj;
+			}
+
+			// nobody else is allocating this zone, so we do it on this thread
+			if (owner)
+			{
+				Allocate<TZone>();
+			}
+
+			return result.get();
+		}
+
+		/// <summary>
+		/// Gets a handle that gets the global object (optionally from a particular zone) for type <c>TObject</c> on first use
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The handle</returns>
+		/// <example>
+		/// Lazy&lt;TObject&gt; obj = GlobalObject&lt;TObject&gt;::GetLazy();
+		/// </example>
+		template <int TZone = 0>
+		static Lazy<TObject> GetLazy()
+		{
+			return Lazy<TObject>([] { return Get<TZone>(); });
+		}
+
+		/// <summary>
+		/// Gets (and allocates on the <see cref="Executor"/>, if needed) a global object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <param name="token">Token that cancels this request</param>
+		/// <returns>A future for the object</returns>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::GetAsync();
+		/// </example>
+		template <int TZone = 0>
+		static std::future<std::shared_ptr<TObject>> GetAsync(const CancellationToken& token = CancellationToken())
+		{
+			return GetAsync<TZone>(std::chrono::steady_clock::time_point::max(), token);
+		}
+
+		/// <summary>
+		/// Gets (and allocates on the <see cref="Executor"/>, if needed) a global object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// Concurrent requests for the same zone share a single allocation, which only runs if at least one request is still waiting for it.
+		/// A request that is canceled, or whose deadline passes, fails right away with <see cref="CanceledException"/> or <see cref="DeadlineExceededException"/>,
+		/// even if the allocation is still running
+		/// </remarks>
+		/// <param name="TZone">The zone to get from</param>
+		/// <param name="deadline">The time by which the object must be available</param>
+		/// <param name="token">Token that cancels this request</param>
+		/// <returns>A future for the object</returns>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::GetAsync(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+		/// </example>
+		template <int TZone = 0>
+		static std::future<std::shared_ptr<TObject>> GetAsync(std::chrono::steady_clock::time_point deadline, const CancellationToken& token = CancellationToken())
+		{
+			if (Overrides::IsActive())
+			{
+				auto current = Override<TZone>::Current();
+				if (current != nullptr)
+				{
+					std::promise<std::shared_ptr<TObject>> ready;
+					ready.set_value(current->m_obj);
+					return ready.get_future();
+				}
+			}
+
+			GlobalRegistry::Use(typeid(TObject));
+
+			std::shared_ptr<TObject> obj;
+			std::future<std::shared_ptr<TObject>> result;
+			bool refresh = false;
+			bool owner = false;
+
+			bool found = Find<TZone>(obj, refresh);
+			if (!found)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				found = Find<TZone>(obj, refresh);
+				if (!found)
+				{
+					result = Join<TZone>(token, deadline, owner);
+				}
+			}
+
+			if (found)
+			{
+				if (refresh)
+				{
+					StartRefresh<TZone>();
+				}
+
+				std::promise<std::shared_ptr<TObject>> ready;
+				ready.set_value(obj);
+				return ready.get_future();
+			}
+
+			if (owner)
+			{
+				Executor::Execute([] { Allocate<TZone>(); });
+			}
+
+			return result;
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		/// <summary>
+		/// Gets (and allocates, if needed) a global object (optionally from a particular zone) for type <c>TObject</c>, awaiting coroutine allocators
+		/// </summary>
+		/// <remarks>
+		/// Shares in-progress allocations with <see cref="Get"/> and <see cref="GetAsync"/>, and suspends (rather than blocks) while waiting on them
+		/// </remarks>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>A task for the object</returns>
+		/// <example>
+		/// auto obj = co_await GlobalObject&lt;TObject&gt;::CoGet();
+		/// </example>
+		template <int TZone = 0>
+		static Task<std::shared_ptr<TObject>> CoGet()
+		{
+			if (Overrides::IsActive())
+			{
+				auto current = Override<TZone>::Current();
+				if (current != nullptr)
+				{
+					co_return current->m_obj;
+				}
+			}
+
+			ConstructionPlan::Check(Key<TZone>(), true);
+
+			JoinAwaiter<TZone> join;
+			co_await join;
+
+			if (join.Owner && !Abandon(TZone))
+			{
+				auto started = Stamp(ZoneSlot<TZone>());
+				std::shared_ptr<TObject> obj;
+				std::exception_ptr error;
+
+				try
+				{
+					// lives in the coroutine frame, and is carried across suspensions (see CoroutineContext)
+					Allocation<TZone> allocation;
+					obj = co_await Object<TObject>::template CoGet<TZone>();
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				Complete(TZone, obj, error, started);
+			}
+
+			co_return join.Result.get();
+		}
+
+#endif
+		/// <summary>
+		/// Resets the global object cache for all zones for type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// An allocation in progress for the zone still completes those waiting on it, but its object isn't cached
+		/// </remarks>
+		/// <param name="TZone">The zone to reset</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Reset<1>();
+		/// </example>
+		template <int TZone>
+		static void Reset()
+		{
+			std::vector<Entry*> removed;
+
+			// destroy outside of the lock, in case the destructor uses globals
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				Remove(TZone, removed);
+				++ZoneSlot<TZone>().Resets;
+			}
+
+			// readers may still be using the entry, so it's destroyed once they're done
+			Retire(removed);
+			Epoch::Synchronize();
+		}
+
+		/// <summary>
+		/// Resets the global object cache for a particular zone for type <c>TObject</c>, destroying the cleared object on the <see cref="Reclaimer"/> thread
+		/// </summary>
+		/// <param name="TZone">The zone to reset</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::ResetAsync<1>();
+		/// </example>
+		template <int TZone>
+		static void ResetAsync()
+		{
+			std::vector<Entry*> removed;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				Remove(TZone, removed);
+				++ZoneSlot<TZone>().Resets;
+			}
+
+			RetireAsync(removed);
+		}
+
+		/// <summary>
+		/// Resets the global object cache for all zones for type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// Takes constant time, regardless of the number of zones. Cleared objects are destroyed as their zones are next used, a few at a time
+		/// as other zones are allocated, or by <see cref="Collect"/>. Allocations in progress still complete those waiting on them, but their
+		/// objects aren't cached
+		/// </remarks>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Reset();
+		/// </example>
+		static void Reset()
+		{
+			++m_generation;
+		}
+
+		/// <summary>
+		/// Destroys the objects for type <c>TObject</c> that were cleared by <see cref="Reset"/>, but not yet destroyed
+		/// </summary>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Collect();
+		/// </example>
+		static void Collect()
+		{
+			std::vector<Entry*> stale;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				Sweep(m_allocObjMap.size(), stale);
+			}
+
+			Retire(stale);
+			Epoch::Synchronize();
+		}
+
+		/// <summary>
+		/// Resets the global object cache for all zones for type <c>TObject</c>, destroying the cleared objects on the <see cref="Reclaimer"/> thread
+		/// </summary>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::ResetAsync();
+		/// </example>
+		static void ResetAsync()
+		{
+			std::vector<Entry*> removed;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				for (auto& slot : m_allocObjMap)
+				{
+					Unpublish(*slot.second, removed);
+				}
+			}
+
+			RetireAsync(removed);
+		}
+
+		/// <summary>
+		/// Gets the key that identifies the global object (optionally for a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone</param>
+		/// <returns>The key</returns>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Key&lt;1&gt;();
+		/// </example>
+		template <int TZone = 0>
+		static GlobalKey Key()
+		{
+			return GlobalKey(typeid(TObject), TZone);
+		}
+
+		/// <summary>
+		/// Registers the global object (optionally for a particular zone) for type <c>TObject</c> to be created by <see cref="InitializeAll"/>
+		/// </summary>
+		/// <param name="TZone">The zone to register</param>
+		/// <param name="dependencies">The globals that must be created first</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Register({ GlobalObject&lt;TDependency&gt;::Key() });
+		/// </example>
+		template <int TZone = 0>
+		static void Register(std::initializer_list<GlobalKey> dependencies = {})
+		{
+			GlobalRegistry::Add(GlobalRegistry::Registration{ Key<TZone>(), dependencies, [] { Get<TZone>(); } });
+		}
+
+		/// <summary>
+		/// Unregisters the global object (optionally for a particular zone) for type <c>TObject</c> from <see cref="InitializeAll"/>
+		/// </summary>
+		/// <param name="TZone">The zone to unregister</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Unregister();
+		/// </example>
+		template <int TZone = 0>
+		static void Unregister()
+		{
+			GlobalRegistry::Remove(Key<TZone>());
+		}
+
+		/// <summary>
+		/// Sets how long the global object (optionally for a particular zone) for type <c>TObject</c> is cached before it is re-allocated
+		/// </summary>
+		/// <remarks>
+		/// With a non-zero <c>refreshAhead</c>, the first <c>Get</c> within <c>refreshAhead</c> of expiry re-allocates the object on the <see cref="Executor"/>
+		/// and swaps it in once ready, while callers keep getting the current object. If re-allocation fails the current object is kept, and the
+		/// next <c>Get</c> tries again. Applies to objects allocated after the call
+		/// </remarks>
+		/// <param name="TZone">The zone</param>
+		/// <param name="ttl">How long the object is cached</param>
+		/// <param name="refreshAhead">How long before expiry to re-allocate in the background</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::SetLifetime(std::chrono::minutes(5), std::chrono::seconds(30));
+		/// </example>
+		template <int TZone = 0>
+		static void SetLifetime(std::chrono::steady_clock::duration ttl, std::chrono::steady_clock::duration refreshAhead = std::chrono::steady_clock::duration::zero())
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_lifetimes[TZone] = Lifetime{ ttl, std::min(refreshAhead, ttl) };
+		}
+
+		/// <summary>
+		/// Clears the lifetime of the global object (optionally for a particular zone) for type <c>TObject</c>, so it is cached until reset
+		/// </summary>
+		/// <param name="TZone">The zone</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::ClearLifetime();
+		/// </example>
+		template <int TZone = 0>
+		static void ClearLifetime()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_lifetimes.erase(TZone);
+		}
+
+		/// <summary>
+		/// Sets a budget for the global objects (across all zones) for type <c>TObject</c>, evicting zones that haven't been used recently once it is exceeded
+		/// </summary>
+		/// <remarks>
+		/// Each object costs 1 unless a cost function is given, making the budget a count of zones. Evicted objects stay alive for as long as callers
+		/// hold them, and are re-allocated by the next <c>Get</c> for their zone. The cost function is called with the cache locked, so it must not use
+		/// <c>GlobalObject&lt;TObject&gt;</c>. Applies to objects allocated after the call
+		/// </remarks>
+		/// <param name="budget">The total cost that may be cached</param>
+		/// <param name="cost">Optional function that returns the cost (for instance, the size in bytes) of an object</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::SetBudget(64 * 1024 * 1024, [](const TObject&amp; obj) { return obj.Size(); });
+		/// </example>
+		static void SetBudget(size_t budget, const std::function<size_t(const TObject&)>& cost = nullptr)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_budget = budget;
+			m_costFunc = cost;
+		}
+
+		/// <summary>
+		/// Clears the budget for the global objects for type <c>TObject</c>, so zones are never evicted
+		/// </summary>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::ClearBudget();
+		/// </example>
+		static void ClearBudget()
+		{
+			SetBudget(std::numeric_limits<size_t>::max());
+		}
+
+		/// <summary>
+		/// Marks the global object (optionally for a particular zone) for type <c>TObject</c> as safe to release under memory pressure
+		/// </summary>
+		/// <remarks>
+		/// Evictable objects are released by <see cref="Trim"/>, and re-allocated by the next <c>Get</c> for their zone
+		/// </remarks>
+		/// <param name="TZone">The zone</param>
+		/// <param name="evictable">false to stop releasing the object</param>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::SetEvictable&lt;10&gt;();
+		/// </example>
+		template <int TZone = 0>
+		static void SetEvictable(bool evictable = true)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (evictable)
+			{
+				m_evictable.insert(TZone);
+			}
+			else
+			{
+				m_evictable.erase(TZone);
+			}
+		}
+
+		/// <summary>
+		/// Releases the evictable global objects for type <c>TObject</c>, along with those cleared by <see cref="Reset"/> but not yet destroyed
+		/// </summary>
+		/// <remarks>
+		/// Called by <see cref="MemoryPressure::Trim"/>. Released objects stay alive for as long as callers hold them
+		/// </remarks>
+		/// <example>
+		/// GlobalObject&lt;TObject&gt;::Trim();
+		/// </example>
+		static void Trim()
+		{
+			std::vector<Entry*> removed;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				for (auto zone : m_evictable)
+				{
+					Remove(zone, removed);
+				}
+
+				Sweep(m_allocObjMap.size(), removed);
+			}
+
+			Retire(removed);
+			Epoch::Synchronize();
+		}
+	private:
+		/// <summary>
+		/// A request waiting on an allocation
+		/// </summary>
+		struct Waiter
+		{
+			std::shared_ptr<AsyncRequest<std::shared_ptr<TObject>>> Request;
+			std::function<void()> Resume;
+
+			/// <summary>
+			/// Determines if the request no longer wants a result
+			/// </summary>
+			bool IsAbandoned() const
+			{
+				return Request->IsAbandoned();
+			}
+
+			/// <summary>
+			/// Delivers the result of an allocation
+			/// </summary>
+			void Complete(const std::shared_ptr<TObject>& obj, const std::exception_ptr& error)
+			{
+				Request->Complete(obj, error);
+
+				if (Resume)
+				{
+					Resume();
+				}
+			}
+		};
+
+#ifdef CPPFACTORY_COROUTINES
+		/// <summary>
+		/// Awaitable that joins the waiters for a zone, suspending unless the object is cached or the caller is the owner
+		/// </summary>
+		template <int TZone>
+		struct JoinAwaiter
+		{
+			JoinAwaiter() : Owner(false)
+			{
+			}
+
+			bool await_ready() const noexcept
+			{
+				return false;
+			}
+
+			bool await_suspend(std::coroutine_handle<> handle)
+			{
+				std::shared_ptr<TObject> obj;
+				bool refresh = false;
+				bool owner = false;
+
+				if (!Find<TZone>(obj, refresh))
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+
+					if (!Find<TZone>(obj, refresh))
+					{
+						Result = Join<TZone>(CancellationToken(), std::chrono::steady_clock::time_point::max(), owner, [handle] { handle.resume(); });
+						Owner = owner;
+					}
+				}
+
+				if (obj.get() != nullptr)
+				{
+					if (refresh)
+					{
+						StartRefresh<TZone>();
+					}
+
+					std::promise<std::shared_ptr<TObject>> ready;
+					ready.set_value(obj);
+					Result = ready.get_future();
+					return false;
+				}
+
+				// once the lock is released, we may be resumed (and this awaiter destroyed) at any time
+				return !owner;
+			}
+
+			void await_resume() const noexcept
+			{
+			}
+
+			bool Owner;
+			std::future<std::shared_ptr<TObject>> Result;
+		};
+
+#endif
+		/// <summary>
+		/// A cached object, and when it should be refreshed. Only <c>Refreshing</c> and <c>Referenced</c> change once the entry is published
+		/// </summary>
+		struct Entry
+		{
+			Entry(const std::shared_ptr<TObject>& instance, size_t cost, uint64_t generation) :
+				Instance(instance),
+				RefreshAt(std::chrono::steady_clock::time_point::max()),
+				Expires(std::chrono::steady_clock::time_point::max()),
+				Refreshing(false),
+				Cost(cost),
+				Referenced(false),
+				Generation(generation)
+			{
+			}
+
+			std::shared_ptr<TObject> Instance;
+			std::chrono::steady_clock::time_point RefreshAt;
+			std::chrono::steady_clock::time_point Expires;
+			std::atomic<bool> Refreshing;
+			size_t Cost;
+			std::atomic<bool> Referenced;
+			uint64_t Generation;
+		};
+
+		/// <summary>
+		/// Where the entry for a zone is published, so readers can find it without taking <c>m_mutex</c>. Slots with an entry are
+		/// linked into a ring (guarded by <c>m_mutex</c>) that the eviction hand sweeps
+		/// </summary>
+		struct Slot
+		{
+			Slot() : Current(nullptr), Resets(0), Prev(nullptr), Next(nullptr)
+			{
+			}
+
+			~Slot()
+			{
+				delete Current.load();
+			}
+
+			std::atomic<Entry*> Current;
+
+			// counts resets of the zone, so allocations they race aren't cached
+			std::atomic<uint64_t> Resets;
+
+			Slot* Prev;
+			Slot* Next;
+		};
+
+		/// <summary>
+		/// How long objects for a zone are cached
+		/// </summary>
+		struct Lifetime
+		{
+			std::chrono::steady_clock::duration Ttl;
+			std::chrono::steady_clock::duration RefreshAhead;
+		};
+
+		/// <summary>
+		/// Gets the slot for a zone
+		/// </summary>
+		template <int TZone>
+		static Slot& ZoneSlot()
+		{
+			static Slot slot;
+			return slot;
+		}
+
+		/// <summary>
+		/// Looks up the cached object for a zone, without taking <c>m_mutex</c>
+		/// </summary>
+		/// <param name="obj">Set to the cached object, if there is one that may be used</param>
+		/// <param name="refresh">Set to true if the caller is responsible for starting a refresh</param>
+		/// <returns>true if there is a cached object that may be used</returns>
+		template <int TZone>
+		static bool Find(std::shared_ptr<TObject>& obj, bool& refresh)
+		{
+			Epoch::Guard guard;
+
+			// entries from before the last reset are as good as missing
+			auto entry = ZoneSlot<TZone>().Current.load();
+			if (entry == nullptr || entry->Generation != m_generation.load())
+			{
+				return false;
+			}
+
+			// only objects with a lifetime pay for reading the clock
+			if (entry->RefreshAt != std::chrono::steady_clock::time_point::max() && !entry->Refreshing.load())
+			{
+				auto now = std::chrono::steady_clock::now();
+				if (now >= entry->Expires)
+				{
+					return false;
+				}
+				else if (now >= entry->RefreshAt && !entry->Refreshing.exchange(true))
+				{
+					refresh = true;
+				}
+			}
+
+			// only the first hit after the eviction hand passes writes, so repeated hits leave the entry's cache line alone
+			if (!entry->Referenced.load(std::memory_order_relaxed))
+			{
+				entry->Referenced.store(true, std::memory_order_relaxed);
+			}
+
+			obj = entry->Instance;
+			return true;
+		}
+
+		/// <summary>
+		/// Removes the cached object for a zone, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="removed">Receives the removed entry, so it may be retired outside of the lock</param>
+		static void Remove(int zone, std::vector<Entry*>& removed)
+		{
+			auto found = m_allocObjMap.find(zone);
+			if (found != m_allocObjMap.end())
+			{
+				Unpublish(*found->second, removed);
+			}
+		}
+
+		/// <summary>
+		/// Clears a slot, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="removed">Receives the removed entry, so it may be retired outside of the lock</param>
+		static void Unpublish(Slot& slot, std::vector<Entry*>& removed)
+		{
+			auto entry = slot.Current.exchange(nullptr);
+			if (entry != nullptr)
+			{
+				Unlink(slot);
+				m_cost -= entry->Cost;
+				removed.push_back(entry);
+			}
+		}
+
+		/// <summary>
+		/// Adds a slot that just got an entry to the eviction ring, just behind the hand so it is visited last, must be called with <c>m_mutex</c> held
+		/// </summary>
+		static void Link(Slot& slot)
+		{
+			if (m_hand == nullptr)
+			{
+				slot.Prev = &slot;
+				slot.Next = &slot;
+				m_hand = &slot;
+				return;
+			}
+
+			slot.Next = m_hand;
+			slot.Prev = m_hand->Prev;
+			slot.Prev->Next = &slot;
+			m_hand->Prev = &slot;
+		}
+
+		/// <summary>
+		/// Removes a slot that lost its entry from the eviction ring, must be called with <c>m_mutex</c> held
+		/// </summary>
+		static void Unlink(Slot& slot)
+		{
+			if (slot.Next == &slot)
+			{
+				m_hand = nullptr;
+			}
+			else
+			{
+				if (m_hand == &slot)
+				{
+					m_hand = slot.Next;
+				}
+
+				slot.Prev->Next = slot.Next;
+				slot.Next->Prev = slot.Prev;
+			}
+
+			slot.Prev = nullptr;
+			slot.Next = nullptr;
+		}
+
+		/// <summary>
+		/// Caches a newly allocated object, evicting zones that haven't been used recently if over budget, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="evicted">Receives the previous and evicted entries, so they may be retired outside of the lock</param>
+		static void Store(int zone, const std::shared_ptr<TObject>& obj, std::vector<Entry*>& evicted)
+		{
+			Track();
+
+			auto& slot = *m_allocObjMap.find(zone)->second;
+			auto entry = MakeEntry(zone, obj);
+			m_cost += entry->Cost;
+
+			auto previous = slot.Current.exchange(entry);
+			if (previous != nullptr)
+			{
+				m_cost -= previous->Cost;
+				evicted.push_back(previous);
+			}
+			else
+			{
+				Link(slot);
+			}
+
+			// amortize removing what earlier resets left behind
+			Sweep(SweepLimit, evicted);
+
+			// the hand spares (once) zones used since it last passed them, which approximates least recently used, and only
+			// visits cached zones, so each eviction is amortized O(1)
+			while (m_cost > m_budget)
+			{
+				auto candidate = m_hand;
+				m_hand = candidate->Next;
+
+				// never evict what we just stored
+				if (candidate == &slot)
+				{
+					if (candidate->Next == candidate)
+					{
+						break;
+					}
+
+					continue;
+				}
+
+				if (!candidate->Current.load()->Referenced.exchange(false))
+				{
+					Unpublish(*candidate, evicted);
+				}
+			}
+		}
+
+		/// <summary>
+		/// Adds this type to the <see cref="GlobalRegistry"/> and <see cref="MemoryPressure"/>, so <see cref="ResetAll"/> and trims can find it
+		/// </summary>
+		static void Track()
+		{
+			static const bool tracked = (GlobalRegistry::AddType(GlobalRegistry::Type{ typeid(TObject), [] { Reset(); Collect(); } }), MemoryPressure::Add([] { Trim(); }), true);
+			(void)tracked;
+		}
+
+		/// <summary>
+		/// Removes entries from before the last reset, visiting at most <c>limit</c> zones and resuming where the last sweep
+		/// left off, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="stale">Receives the removed entries, so they may be retired outside of the lock</param>
+		static void Sweep(size_t limit, std::vector<Entry*>& stale)
+		{
+			auto slot = m_allocObjMap.lower_bound(m_sweepZone);
+
+			for (size_t visited = 0; visited < limit && !m_allocObjMap.empty(); ++visited)
+			{
+				if (slot == m_allocObjMap.end())
+				{
+					slot = m_allocObjMap.begin();
+				}
+
+				auto entry = slot->second->Current.load();
+				if (entry != nullptr && entry->Generation != m_generation.load())
+				{
+					Unpublish(*slot->second, stale);
+				}
+
+				++slot;
+			}
+
+			m_sweepZone = slot == m_allocObjMap.end() ? std::numeric_limits<int>::min() : slot->first;
+		}
+
+		/// <summary>
+		/// Hands removed entries to <see cref="Epoch"/>, which destroys them once no reader can see them
+		/// </summary>
+		static void Retire(const std::vector<Entry*>& removed)
+		{
+			for (auto entry : removed)
+			{
+				Epoch::Retire(entry);
+			}
+		}
+
+		/// <summary>
+		/// Hands removed entries to <see cref="Epoch"/>, which passes them to the <see cref="Reclaimer"/> thread once no reader can see them
+		/// </summary>
+		static void RetireAsync(const std::vector<Entry*>& removed)
+		{
+			for (auto entry : removed)
+			{
+				Epoch::Retire<Entry, DeferredDeleter<Entry>>(entry);
+			}
+
+			Epoch::Synchronize();
+		}
+
+		/// <summary>
+		/// Creates a cache entry for a newly allocated object, must be called with <c>m_mutex</c> held
+		/// </summary>
+		static Entry* MakeEntry(int zone, const std::shared_ptr<TObject>& obj)
+		{
+			auto entry = new Entry(obj, m_costFunc ? m_costFunc(*obj) : 1, m_generation.load());
+
+			auto lifetime = m_lifetimes.find(zone);
+			if (lifetime != m_lifetimes.end())
+			{
+				auto now = std::chrono::steady_clock::now();
+				entry->Expires = now + lifetime->second.Ttl;
+				entry->RefreshAt = entry->Expires - lifetime->second.RefreshAhead;
+			}
+
+			return entry;
+		}
+
+		/// <summary>
+		/// Re-allocates the object for a zone on the <see cref="Executor"/>, and swaps it into the cache
+		/// </summary>
+		template <int TZone>
+		static void StartRefresh()
+		{
+			Executor::Execute([] {
+				if (RefreshInPlace<TZone>())
+				{
+					return;
+				}
+
+				std::shared_ptr<TObject> obj;
+
+				try
+				{
+					Allocation<TZone> allocation;
+					obj = Object<TObject>::template Get<TZone>();
+				}
+				catch (...)
+				{
+					// keep the current object, and try again on the next get
+				}
+
+				std::vector<Entry*> replaced;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+
+					// the zone may have been reset while we were allocating
+					auto entry = ZoneSlot<TZone>().Current.load();
+					if (entry == nullptr || !entry->Refreshing.load() || entry->Generation != m_generation.load())
+					{
+						return;
+					}
+
+					if (obj.get() != nullptr)
+					{
+						Store(TZone, obj, replaced);
+					}
+					else
+					{
+						entry->Refreshing.store(false);
+					}
+				}
+
+				Retire(replaced);
+			});
+		}
+
+		/// <summary>
+		/// Refreshes the object for a zone by resetting it in place, if the zone has a reset function and nobody else holds the object
+		/// </summary>
+		/// <returns>true if the refresh is done, false if the object should be re-allocated instead</returns>
+		template <int TZone>
+		static bool RefreshInPlace()
+		{
+			if (!Object<TObject>::template HasReset<TZone>())
+			{
+				return false;
+			}
+
+			auto& slot = ZoneSlot<TZone>();
+			std::vector<Entry*> replaced;
+			std::shared_ptr<TObject> obj;
+			uint64_t started;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto entry = slot.Current.load();
+				if (entry == nullptr || !entry->Refreshing.load() || entry->Generation != m_generation.load())
+				{
+					return true;
+				}
+
+				// take the object out of readers' reach. Gets that miss meanwhile join the pending allocation, which the refresh completes
+				Unpublish(slot, replaced);
+				obj = entry->Instance;
+				started = Stamp(slot);
+
+				Waiter refresh;
+				refresh.Request = AsyncRequest<std::shared_ptr<TObject>>::Create(CancellationToken(), std::chrono::steady_clock::time_point::max());
+				m_pending[TZone].push_back(std::move(refresh));
+			}
+
+			// wait for readers that may have loaded the entry already. The lock isn't held, since a reader may be waiting for it
+			bool idle = Epoch::Wait() && obj.use_count() == 2;
+
+			if (!idle)
+			{
+				std::vector<Waiter> waiters;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+
+					// the zone may have been reset while we were waiting, in which case the old object mustn't come back
+					if (started == Stamp(slot))
+					{
+						slot.Current.store(replaced.front());
+						Link(slot);
+						m_cost += replaced.front()->Cost;
+						replaced.clear();
+
+						waiters.swap(m_pending[TZone]);
+						m_pending.erase(TZone);
+					}
+				}
+
+				if (!replaced.empty())
+				{
+					Retire(replaced);
+					Allocate<TZone>();
+					return true;
+				}
+
+				for (auto& waiter : waiters)
+				{
+					waiter.Complete(obj, nullptr);
+				}
+
+				return false;
+			}
+
+			Retire(replaced);
+
+			try
+			{
+				if (started == Stamp(slot))
+				{
+					Object<TObject>::template ResetInPlace<TZone>(*obj);
+					Complete(TZone, obj, nullptr, started);
+					return true;
+				}
+			}
+			catch (...)
+			{
+				// the object may be half reset, so it can't be reused
+			}
+
+			Allocate<TZone>();
+			return true;
+		}
+
+		/// <summary>
+		/// Adds a waiter for a zone, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="owner">Set to true if the caller is responsible for starting the allocation</param>
+		/// <param name="resume">Optional function to call once the result is available, unless the caller is the owner</param>
+		template <int TZone>
+		static std::future<std::shared_ptr<TObject>> Join(const CancellationToken& token, std::chrono::steady_clock::time_point deadline, bool& owner, const std::function<void()>& resume = nullptr)
+		{
+			// the zone's slot is published here, so the allocation has somewhere to store its result
+			m_allocObjMap.insert(std::make_pair(TZone, &ZoneSlot<TZone>()));
+
+			auto& waiters = m_pending[TZone];
+			owner = waiters.empty();
+
+			Waiter waiter;
+			waiter.Request = AsyncRequest<std::shared_ptr<TObject>>::Create(token, deadline);
+			waiter.Resume = owner ? nullptr : resume;
+			auto result = waiter.Request->GetFuture();
+			waiters.push_back(std::move(waiter));
+
+			return result;
+		}
+
+		/// <summary>
+		/// The scopes the owner of a zone's allocation holds while the allocator runs, shared by <see cref="Allocate"/>, <see cref="CoGet"/>
+		/// and refreshes. Overrides are suppressed, since the object is shared with other threads
+		/// </summary>
+		template <int TZone>
+		class Allocation
+		{
+		public:
+			Allocation() : m_allocating(typeid(TObject)), m_building(Key<TZone>(), true)
+			{
+			}
+
+			Allocation(const Allocation&) = delete;
+			Allocation& operator=(const Allocation&) = delete;
+
+		private:
+			Overrides::Suppression m_suppression;
+			GlobalRegistry::AllocationScope m_allocating;
+			ConstructionPlan::Scope m_building;
+		};
+
+		/// <summary>
+		/// Allocates the object for a zone and completes everyone waiting on it
+		/// </summary>
+		template <int TZone>
+		static void Allocate()
+		{
+			if (Abandon(TZone))
+			{
+				return;
+			}
+
+			auto started = Stamp(ZoneSlot<TZone>());
+			std::shared_ptr<TObject> obj;
+			std::exception_ptr error;
+
+			try
+			{
+				Allocation<TZone> allocation;
+				obj = Object<TObject>::template Get<TZone>();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			Complete(TZone, obj, error, started);
+		}
+
+		/// <summary>
+		/// Completes everyone waiting on a zone without allocating, if none of them want the object anymore
+		/// </summary>
+		/// <returns>true if the allocation was abandoned</returns>
+		static bool Abandon(int zone)
+		{
+			std::vector<Waiter> waiters;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto& pending = m_pending[zone];
+				if (!std::all_of(pending.begin(), pending.end(), [](const Waiter& waiter) { return waiter.IsAbandoned(); }))
+				{
+					return false;
+				}
+
+				waiters.swap(pending);
+				m_pending.erase(zone);
+			}
+
+			for (auto& waiter : waiters)
+			{
+				waiter.Complete(nullptr, nullptr);
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Stamps the state of a zone, which resets of the type and of the zone both change
+		/// </summary>
+		static uint64_t Stamp(const Slot& slot)
+		{
+			// both only grow, so the sum changes if either does
+			return m_generation.load() + slot.Resets.load();
+		}
+
+		/// <summary>
+		/// Caches the result of an allocation and completes everyone waiting on it
+		/// </summary>
+		/// <param name="started">The <see cref="Stamp"/> of the zone when the allocation started</param>
+		static void Complete(int zone, const std::shared_ptr<TObject>& obj, const std::exception_ptr& error, uint64_t started)
+		{
+			std::vector<Waiter> waiters;
+			std::vector<Entry*> evicted;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				// a reset that raced the allocation may have cleared what the object was built from, so it goes to the waiters, but isn't cached
+				if (obj.get() != nullptr && started == Stamp(*m_allocObjMap.find(zone)->second))
+				{
+					Store(zone, obj, evicted);
+				}
+
+				waiters.swap(m_pending[zone]);
+				m_pending.erase(zone);
+			}
+
+			Retire(evicted);
+
+			for (auto& waiter : waiters)
+			{
+				waiter.Complete(obj, error);
+			}
+		}
+
+		/// <summary>
+		/// The type of the allocated object map
+		/// </summary>
+		typedef std::map<int, Slot*> AllocObjMapType;
+
+		/// <summary>
+		/// The type of the pending allocation map
+		/// </summary>
+		typedef std::map<int, std::vector<Waiter>> PendingMapType;
+
+		/// <summary>
+		/// The type of the lifetime map
+		/// </summary>
+		typedef std::map<int, Lifetime> LifetimeMapType;
+
+		/// <summary>
+		/// The slots of the zones that have been used, which are never removed
+		/// </summary>
+		static AllocObjMapType m_allocObjMap;
+
+		/// <summary>
+		/// The requests waiting on in-progress allocations, by zone
+		/// </summary>
+		static PendingMapType m_pending;
+
+		/// <summary>
+		/// The lifetimes of cached objects, by zone
+		/// </summary>
+		static LifetimeMapType m_lifetimes;
+
+		/// <summary>
+		/// The zones that may be released under memory pressure
+		/// </summary>
+		static std::set<int> m_evictable;
+
+		/// <summary>
+		/// The total cost that may be cached
+		/// </summary>
+		static size_t m_budget;
+
+		/// <summary>
+		/// The total cost of the cached objects
+		/// </summary>
+		static size_t m_cost;
+
+		/// <summary>
+		/// The function that determines the cost of an object, or empty for a cost of 1
+		/// </summary>
+		static std::function<size_t(const TObject&)> m_costFunc;
+
+		/// <summary>
+		/// The next cached zone the eviction hand visits, or null if none are cached
+		/// </summary>
+		static Slot* m_hand;
+
+		/// <summary>
+		/// Incremented by each reset, so entries from earlier generations can be ignored. Read without the lock
+		/// </summary>
+		static std::atomic<uint64_t> m_generation;
+
+		/// <summary>
+		/// The zone the next sweep resumes from
+		/// </summary>
+		static int m_sweepZone;
+
+		/// <summary>
+		/// The number of entries each allocation sweeps
+		/// </summary>
+		static const size_t SweepLimit = 4;
+
+		/// <summary>
+		/// Guards all of the above, except for what readers use
+		/// </summary>
+		static std::mutex m_mutex;
+	};
+
+	template <class TObject>
+	typename GlobalObject<TObject>::AllocObjMapType GlobalObject<TObject>::m_allocObjMap = GlobalObject<TObject>::AllocObjMapType();
+
+	template <class TObject>
+	typename GlobalObject<TObject>::PendingMapType GlobalObject<TObject>::m_pending = GlobalObject<TObject>::PendingMapType();
+
+	template <class TObject>
+	typename GlobalObject<TObject>::LifetimeMapType GlobalObject<TObject>::m_lifetimes = GlobalObject<TObject>::LifetimeMapType();
+
+	template <class TObject>
+	std::set<int> GlobalObject<TObject>::m_evictable;
+
+	template <class TObject>
+	size_t GlobalObject<TObject>::m_budget = std::numeric_limits<size_t>::max();
+
+	template <class TObject>
+	size_t GlobalObject<TObject>::m_cost = 0;
+
+	template <class TObject>
+	std::function<size_t(const TObject&)> GlobalObject<TObject>::m_costFunc;
+
+	template <class TObject>
+	typename GlobalObject<TObject>::Slot* GlobalObject<TObject>::m_hand = nullptr;
+
+	template <class TObject>
+	std::atomic<uint64_t> GlobalObject<TObject>::m_generation(0);
+
+	template <class TObject>
+	int GlobalObject<TObject>::m_sweepZone = std::numeric_limits<int>::min();
+
+	template <class TObject>
+	std::mutex GlobalObject<TObject>::m_mutex;
+
+	/// <summary>
+	/// Represents an <see cref="Object"/> that is shared while it is in use, meaning
+	/// it is destroyed once nobody holds a reference to it, and re-allocated by the next <c>Get</c>
+	/// </summary>
+	/// <remarks>
+	/// Safe to use from multiple threads. Note that an object allocated by <c>std::make_shared</c> shares its storage with the
+	/// reference counts, so its destructor runs on release but the storage itself is only freed once the cache entry is replaced or reset
+	/// </remarks>
+	/// <param name="TObject">The type of object</param>
+	template <class TObject>
+	class WeakGlobalObject
+	{
+	public:
+		/// <summary>
+		/// Gets (and allocates, if nobody else holds it) a shared object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		/// <example>
+		/// WeakGlobalObject&lt;TObject&gt;::Get();
+		/// </example>
+		template <int TZone = 0>
+		static std::shared_ptr<TObject> Get()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto obj = m_allocObjMap[TZone].lock();
+				if (obj.get() != nullptr)
+				{
+					return obj;
+				}
+			}
+
+			// allocate without the lock, in case the allocator uses weak globals
+			std::shared_ptr<TObject> obj;
+			{
+				Overrides::Suppression suppression;
+				obj = Object<TObject>::template Get<TZone>();
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// someone else may have beaten us to it, in which case we share theirs
+			auto existing = m_allocObjMap[TZone].lock();
+			if (existing.get() != nullptr)
+			{
+				return existing;
+			}
+
+			m_allocObjMap[TZone] = obj;
+			return obj;
+		}
+
+		/// <summary>
+		/// Resets the shared object cache for a particular zone for type <c>TObject</c>. Objects that are still held are unaffected
+		/// </summary>
+		/// <param name="TZone">The zone to reset</param>
+		/// <example>
+		/// WeakGlobalObject&lt;TObject&gt;::Reset<1>();
+		/// </example>
+		template <int TZone>
+		static void Reset()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_allocObjMap.erase(TZone);
+		}
+
+		/// <summary>
+		/// Resets the shared object cache for all zones for type <c>TObject</c>. Objects that are still held are unaffected
+		/// </summary>
+		/// <example>
+		/// WeakGlobalObject&lt;TObject&gt;::Reset();
+		/// </example>
+		static void Reset()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_allocObjMap.clear();
+		}
+
+	private:
+		/// <summary>
+		/// The type of the allocated object map
+		/// </summary>
+		typedef std::map<int, std::weak_ptr<TObject>> AllocObjMapType;
+
+		/// <summary>
+		/// The allocated object map
+		/// </summary>
+		static AllocObjMapType m_allocObjMap;
+
+		/// <summary>
+		/// Guards <c>m_allocObjMap</c>
+		/// </summary>
+		static std::mutex m_mutex;
+	};
+
+	template <class TObject>
+	typename WeakGlobalObject<TObject>::AllocObjMapType WeakGlobalObject<TObject>::m_allocObjMap = WeakGlobalObject<TObject>::AllocObjMapType();
+
+	template <class TObject>
+	std::mutex WeakGlobalObject<TObject>::m_mutex;
+
+	/// <summary>
+	/// Represents an object that is created via a "factory"
+	/// </summary>
+	/// <param name="TObject">The type of object</param>
+	template <class TObject>
+	class Object
+	{
+	public:
+		/// <summary>
+		/// Gets the object from the rest of a decorator chain, that is from the decorators added before the current one, and then the allocator
+		/// </summary>
+		class Next
+		{
+		public:
+			std::shared_ptr<TObject> operator()() const
+			{
+				return m_decorator == m_end ? (*m_alloc)() : (*m_decorator)(Next(m_decorator + 1, m_end, m_alloc));
+			}
+
+		private:
+			friend class Object;
+
+			typedef std::function<std::shared_ptr<TObject>(const Next&)> DecoratorFuncType;
+
+			Next(const DecoratorFuncType* decorator, const DecoratorFuncType* end, const std::function<std::shared_ptr<TObject>()>* alloc) :
+				m_decorator(decorator), m_end(end), m_alloc(alloc)
+			{
+			}
+
+			const DecoratorFuncType* m_decorator;
+			const DecoratorFuncType* m_end;
+			const std::function<std::shared_ptr<TObject>()>* m_alloc;
+		};
+
+		/// <summary>
+		/// Replaces the allocator for a zone on the calling thread only, until destroyed. Overrides nest, and must be destroyed on
+		/// the thread that created them
+		/// </summary>
+		/// <remarks>
+		/// Applies to <see cref="Get"/> (including auto-wired dependencies), <see cref="GetAsync"/>, <see cref="CoGet"/> and <see cref="PooledObject::Get"/>
+		/// on the calling thread, but not while allocating objects shared with other threads, such as a <see cref="GlobalObject"/>
+		/// </remarks>
+		/// <param name="TZone">The zone to override</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::Override&lt;&gt; mock([] { return std::make_shared&lt;TMock&gt;(); });
+		/// </example>
+		template <int TZone = 0>
+		class Override
+		{
+		public:
+			/// <param name="alloc">Function that allocates an object</param>
+			explicit Override(const std::function<std::shared_ptr<TObject>()>& alloc) : m_alloc(alloc), m_previous(Current())
+			{
+				Current() = this;
+				Overrides::Add();
+			}
+
+			~Override()
+			{
+				Current() = m_previous;
+				Overrides::Remove();
+			}
+
+			Override(const Override&) = delete;
+			Override& operator=(const Override&) = delete;
+
+		private:
+			friend class Object;
+
+			/// <summary>
+			/// The innermost override on the calling thread
+			/// </summary>
+			static Override*& Current()
+			{
+				static thread_local Override* current = nullptr;
+				return current;
+			}
+
+			std::function<std::shared_ptr<TObject>()> m_alloc;
+			Override* m_previous;
+		};
+
+		/// <summary>
+		/// Registers logic capable of allocating (and optionally deallocating) an object of type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to register for</param>
+		/// <param name="alloc">Function that allocates an object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::RegisterAllocator([] { return std::make_shared<TObject>(); });
+		/// </example>
+		template <int TZone = 0>
+		static void RegisterAllocator(const std::function<std::shared_ptr<TObject>()>& alloc)
+		{
+			Update([&] {
+				Attach<TZone>();
+				m_registered[TZone] = std::make_shared<const AllocFuncType>(alloc);
+#ifdef CPPFACTORY_COROUTINES
+				m_coAllocFunc.erase(TZone);
+#endif
+			});
+		}
+
+		/// <summary>
+		/// Registers an allocator that gets a <c>TImplementation</c> from <see cref="Object"/>, binding an interface to its implementation
+		/// </summary>
+		/// <remarks>
+		/// To bind at compile time instead, specialize <see cref="Implementation"/>
+		/// </remarks>
+		/// <param name="TImplementation">The type to get</param>
+		/// <param name="TZone">The zone to register for, which is also the zone the implementation is gotten from</param>
+		/// <example>
+		/// Object&lt;TInterface&gt;::Bind&lt;TImplementation&gt;();
+		/// </example>
+		template <class TImplementation, int TZone = 0>
+		static void Bind()
+		{
+			static_assert(std::is_convertible<TImplementation*, TObject*>::value, "TImplementation must publicly derive from TObject");
+
+			RegisterAllocator<TZone>([] { return std::shared_ptr<TObject>(Object<TImplementation>::template Get<TZone>()); });
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		/// <summary>
+		/// Registers a coroutine capable of allocating (and optionally deallocating) an object of type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// <see cref="CoGet"/> awaits the coroutine, while <see cref="Get"/> blocks until it finishes
+		/// </remarks>
+		/// <param name="TZone">The zone to register for</param>
+		/// <param name="alloc">Coroutine that allocates an object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::RegisterAllocator([]() -&gt; Task&lt;std::shared_ptr&lt;TObject&gt;&gt; { co_await io; co_return std::make_shared&lt;TObject&gt;(); });
+		/// </example>
+		template <int TZone = 0>
+		static void RegisterAllocator(const std::function<Task<std::shared_ptr<TObject>>()>& alloc)
+		{
+			Update([&] {
+				Attach<TZone>();
+				m_coAllocFunc[TZone] = alloc;
+				m_registered[TZone] = std::make_shared<const AllocFuncType>([alloc] { return SyncWait(alloc()); });
+			});
+		}
+#endif
+
+		/// <summary>
+		/// Registers logic capable of allocating an object of type <c>TObject</c> under a name, which zones use once they are bound
+		/// to it via <see cref="Bindings::Load"/>
+		/// </summary>
+		/// <remarks>
+		/// Registering a name again replaces this type's allocator with that name, but not other types'. Zones that are already bound
+		/// keep the allocator they were bound to
+		/// </remarks>
+		/// <param name="name">The name</param>
+		/// <param name="alloc">Function that allocates an object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::RegisterAllocator("store.postgres", [] { return std::make_shared&lt;TObject&gt;(); });
+		/// </example>
+		static void RegisterAllocator(const std::string& name, const std::function<std::shared_ptr<TObject>()>& alloc)
+		{
+			auto registered = std::make_shared<const AllocFuncType>(alloc);
+
+			Bindings::Add(typeid(TObject), name, [registered](int zone) {
+				Update([&] {
+					m_registered[zone] = registered;
+#ifdef CPPFACTORY_COROUTINES
+					m_coAllocFunc.erase(zone);
+#endif
+				});
+			});
+		}
+
+		/// <summary>
+		/// Adds logic capable of allocating an object of type <c>TObject</c> to the list for a zone, which <see cref="GetAll"/> calls in the
+		/// order they were added. Lists are separate from the allocator <see cref="Get"/> uses
+		/// </summary>
+		/// <param name="TZone">The zone to add to</param>
+		/// <param name="alloc">Function that allocates an object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::AddAllocator([] { return std::make_shared&lt;TObject&gt;(); });
+		/// </example>
+		template <int TZone = 0>
+		static void AddAllocator(const std::function<std::shared_ptr<TObject>()>& alloc)
+		{
+			AllocListPtr* previous;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto& slot = ListSlot<TZone>();
+				m_allocList.insert(std::make_pair(TZone, &slot));
+
+				auto current = slot.load();
+				auto list = current == nullptr ? std::make_shared<AllocListType>() : std::make_shared<AllocListType>(**current);
+				list->push_back(alloc);
+
+				previous = slot.exchange(new AllocListPtr(std::move(list)));
+			}
+
+			// concurrent gets may still be reading the previous list
+			if (previous != nullptr)
+			{
+				Epoch::Retire(previous);
+			}
+		}
+
+		/// <summary>
+		/// Unregisters all allocators for all zones for type <c>TObject</c>, including those added via <see cref="AddAllocator"/>
+		/// </summary>
+		/// <remarks>
+		/// Zone fallbacks are kept, see <see cref="ClearFallback"/>. So are decorators, which wrap the default construction until
+		/// the next allocator is registered, see <see cref="ClearDecorators"/>
+		/// </remarks>
+		/// <example>
+		/// Object&lt;TObject&gt;::UnregisterAllocator();
+		/// </example>
+		static void UnregisterAllocator()
+		{
+			Update([] {
+				m_registered.clear();
+#ifdef CPPFACTORY_COROUTINES
+				m_coAllocFunc.clear();
+#endif
+			});
+
+			ClearLists([](int) { return true; });
+		}
+		
+		/// <summary>
+		/// Unregisters all allocators for a particular zone for type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// The zone's decorators are kept, and wrap the default construction until the next allocator is registered for the zone,
+		/// see <see cref="ClearDecorators"/>
+		/// </remarks>
+		/// <param name="TZone">The zone to unregister</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::UnregisterAllocator(10);
+		/// </example>
+		template<int TZone>
+		static void UnregisterAllocator()
+		{
+			Update([] {
+				m_registered.erase(TZone);
+#ifdef CPPFACTORY_COROUTINES
+				m_coAllocFunc.erase(TZone);
+#endif
+			});
+
+			ClearLists([](int zone) { return zone == TZone; });
+		}
+
+		/// <summary>
+		/// Makes a zone use the allocator of another zone, when it has none registered itself
+		/// </summary>
+		/// <remarks>
+		/// Fallbacks chain, so a zone that falls back to a zone with no allocator continues on to that zone's fallback. Chains are resolved
+		/// once per registration change, rather than on each <c>Get</c>. Throws <c>std::logic_error</c> if the fallback would form a cycle
+		/// </remarks>
+		/// <param name="TZone">The zone that falls back</param>
+		/// <param name="TFallback">The zone to fall back to</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::SetFallback&lt;10, 1&gt;();
+		/// </example>
+		template <int TZone, int TFallback>
+		static void SetFallback()
+		{
+			Update([] {
+				// following the chain from the fallback must not lead back here
+				int zone = TFallback;
+				for (auto next = m_fallback.find(zone); zone != TZone && next != m_fallback.end(); next = m_fallback.find(zone))
+				{
+					zone = next->second;
+				}
+
+				if (zone == TZone)
+				{
+					throw std::logic_error("zone fallbacks may not form a cycle");
+				}
+
+				Attach<TZone>();
+				m_fallback[TZone] = TFallback;
+			});
+		}
+
+		/// <summary>
+		/// Clears the fallback of a zone
+		/// </summary>
+		/// <param name="TZone">The zone</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::ClearFallback&lt;10&gt;();
+		/// </example>
+		template <int TZone>
+		static void ClearFallback()
+		{
+			Update([] {
+				m_fallback.erase(TZone);
+			});
+		}
+
+		/// <summary>
+		/// Adds a decorator to a zone, which wraps the decorators added before it and the allocator (or the default construction, if
+		/// none is registered). The chain is composed whenever registrations change, rather than on each <c>Get</c>
+		/// </summary>
+		/// <param name="TZone">The zone to decorate</param>
+		/// <param name="decorator">Function that gets the object by calling <c>next</c>, and may change or replace it</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::Decorate([](const Object&lt;TObject&gt;::Next&amp; next) { return next(); });
+		/// </example>
+		template <int TZone = 0>
+		static void Decorate(const std::function<std::shared_ptr<TObject>(const Next&)>& decorator)
+		{
+			auto defaultAlloc = DefaultAlloc<TZone>(std::integral_constant<bool, CanDefault<TZone>::value>());
+
+			Update([&] {
+				Attach<TZone>();
+
+				auto& decoration = m_decoration[TZone];
+				decoration.Default = defaultAlloc;
+				decoration.Decorators.push_back(decorator);
+			});
+		}
+
+		/// <summary>
+		/// Adds decorators known at compile time to a zone, fused into a single function so that the chain costs one call.
+		/// Each decorator wraps those before it
+		/// </summary>
+		/// <param name="TZone">The zone to decorate</param>
+		/// <param name="TDecorators">Default constructible types, whose <c>operator()</c> takes a callable <c>next</c> and returns the object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::Decorate&lt;0, TLogging, TMetrics&gt;();
+		/// </example>
+		template <int TZone, class TFirst, class... TDecorators>
+		static void Decorate()
+		{
+			Decorate<TZone>([](const Next& next) { return Fuse(next, static_cast<std::tuple<TFirst, TDecorators...>*>(nullptr)); });
+		}
+
+		/// <summary>
+		/// Removes the decorators of a zone
+		/// </summary>
+		/// <param name="TZone">The zone</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::ClearDecorators();
+		/// </example>
+		template <int TZone = 0>
+		static void ClearDecorators()
+		{
+			Update([] {
+				m_decoration.erase(TZone);
+			});
+		}
+
+		/// <summary>
+		/// Registers logic capable of resetting an object of type <c>TObject</c> in place, so it may be reused rather than re-allocated
+		/// </summary>
+		/// <remarks>
+		/// <see cref="PooledObject"/> resets objects as they are recycled, and <see cref="GlobalObject"/> refreshes reset the current object when
+		/// nobody else holds it. The function should clear state but keep capacity, and must not use the type's own global objects, since a refresh
+		/// of them may be waiting on it. If it throws, the object is destroyed rather than reused
+		/// </remarks>
+		/// <param name="TZone">The zone to register for</param>
+		/// <param name="reset">Function that resets an object</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::RegisterReset([](TObject&amp; obj) { obj.Buffer.clear(); });
+		/// </example>
+		template <int TZone = 0>
+		static void RegisterReset(const std::function<void(TObject&)>& reset)
+		{
+			ResetFuncPtr* previous;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				previous = ResetSlot<TZone>().exchange(reset ? new ResetFuncPtr(std::make_shared<ResetFuncType>(reset)) : nullptr);
+			}
+
+			// concurrent recycles may still be calling the previous function
+			Epoch::Retire(previous);
+		}
+
+		/// <summary>
+		/// Unregisters the reset function for a particular zone for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to unregister</param>
+		/// <example>
+		/// Object&lt;TObject&gt;::UnregisterReset();
+		/// </example>
+		template <int TZone = 0>
+		static void UnregisterReset()
+		{
+			RegisterReset<TZone>(nullptr);
+		}
+
+		/// <summary>
+		/// Gets (and allocates, if needed) an object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		/// <example>
+		/// Object<TObject>::Get();
+		/// </example>
+		template <int TZone = 0>
+		static std::shared_ptr<TObject> Get()
+		{
+			std::shared_ptr<TObject> obj;
+			if (Overridden<TZone>(obj))
+			{
+				return obj;
+			}
+
+			return Allocate<TZone>(IsStatic<TZone>());
+		}
+
+		/// <summary>
+		/// Gets an object (optionally from a particular zone) as the type bound to <c>TObject</c> via <see cref="Implementation"/>, so that
+		/// calls through it may be devirtualized. Allocators registered for <c>TObject</c> are not used, since they may return any implementation
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		/// <example>
+		/// std::shared_ptr&lt;TImplementation&gt; obj = Object&lt;TInterface&gt;::GetImplementation();
+		/// </example>
+		template <int TZone = 0>
+		static std::shared_ptr<typename Implementation<TObject, TZone>::type> GetImplementation()
+		{
+			return Object<typename Implementation<TObject, TZone>::type>::template Get<TZone>();
+		}
+
+		/// <summary>
+		/// Allocates one object (optionally from a particular zone) for type <c>TObject</c> with each allocator added via <see cref="AddAllocator"/>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The objects, in the order their allocators were added</returns>
+		/// <example>
+		/// std::vector&lt;std::shared_ptr&lt;TObject&gt;&gt; objs = Object&lt;TObject&gt;::GetAll();
+		/// </example>
+		template <int TZone = 0>
+		static std::vector<std::shared_ptr<TObject>> GetAll()
+		{
+			std::vector<std::shared_ptr<TObject>> objs;
+			AllocListPtr list;
+
+			// copied out of the guard, since the allocators may block
+			{
+				Epoch::Guard guard;
+
+				auto published = ListSlot<TZone>().load();
+				if (published != nullptr)
+				{
+					list = *published;
+				}
+			}
+
+			if (list.get() != nullptr)
+			{
+				objs.reserve(list->size());
+				for (auto& alloc : *list)
+				{
+					objs.push_back(alloc());
+				}
+			}
+
+			return objs;
+		}
+
+		/// <summary>
+		/// Gets a handle that allocates an object (optionally from a particular zone) for type <c>TObject</c> on first use
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The handle</returns>
+		/// <example>
+		/// Lazy&lt;TObject&gt; obj = Object&lt;TObject&gt;::GetLazy();
+		/// </example>
+		template <int TZone = 0>
+		static Lazy<TObject> GetLazy()
+		{
+			return Lazy<TObject>([] { return Get<TZone>(); });
+		}
+
+		/// <summary>
+		/// Gets (allocating on the <see cref="Executor"/>) an object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <param name="token">Token that cancels this request</param>
+		/// <returns>A future for the object</returns>
+		/// <example>
+		/// Object&lt;TObject&gt;::GetAsync();
+		/// </example>
+		template <int TZone = 0>
+		static std::future<std::shared_ptr<TObject>> GetAsync(const CancellationToken& token = CancellationToken())
+		{
+			return GetAsync<TZone>(std::chrono::steady_clock::time_point::max(), token);
+		}
+
+		/// <summary>
+		/// Gets (allocating on the <see cref="Executor"/>) an object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <remarks>
+		/// The allocator is skipped if the request is canceled, or its deadline passes, before it runs. A running allocator is never interrupted,
+		/// but the request fails as soon as it is canceled or its deadline passes, and the object is discarded when the allocator returns
+		/// </remarks>
+		/// <param name="TZone">The zone to get from</param>
+		/// <param name="deadline">The time by which the object must be available</param>
+		/// <param name="token">Token that cancels this request</param>
+		/// <returns>A future for the object</returns>
+		/// <example>
+		/// Object&lt;TObject&gt;::GetAsync(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+		/// </example>
+		template <int TZone = 0>
+		static std::future<std::shared_ptr<TObject>> GetAsync(std::chrono::steady_clock::time_point deadline, const CancellationToken& token = CancellationToken())
+		{
+			// the override belongs to the calling thread, so it is used here rather than on the executor
+			if (Overrides::IsActive() && Override<TZone>::Current() != nullptr)
+			{
+				std::promise<std::shared_ptr<TObject>> ready;
+
+				try
+				{
+					ready.set_value(Override<TZone>::Current()->m_alloc());
+				}
+				catch (...)
+				{
+					ready.set_exception(std::current_exception());
+				}
+
+				return ready.get_future();
+			}
+
+			auto request = AsyncRequest<std::shared_ptr<TObject>>::Create(token, deadline);
+			auto result = request->GetFuture();
+
+			Executor::Execute([request] {
+				std::shared_ptr<TObject> obj;
+				std::exception_ptr error;
+
+				try
+				{
+					if (!request->IsAbandoned())
+					{
+						obj = Get<TZone>();
+					}
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				request->Complete(obj, error);
+			});
+
+			return result;
+		}
+
+#ifdef CPPFACTORY_COROUTINES
+		/// <summary>
+		/// Gets (and allocates, if needed) an object (optionally from a particular zone) for type <c>TObject</c>, awaiting coroutine allocators
+		/// </summary>
+		/// <remarks>
+		/// Allocates as <see cref="Get"/> does: an override comes first, then a <see cref="StaticAllocator"/>, then the zone's allocator. Decorators
+		/// can't await, so a decorated zone's coroutine allocator is blocked on through its decorators rather than awaited
+		/// </remarks>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>A task for the object</returns>
+		/// <example>
+		/// auto obj = co_await Object&lt;TObject&gt;::CoGet();
+		/// </example>
+		template <int TZone = 0>
+		static Task<std::shared_ptr<TObject>> CoGet()
+		{
+			std::shared_ptr<TObject> obj;
+			if (Overridden<TZone>(obj))
+			{
+				co_return obj;
+			}
+
+			// copied, so the coroutine outlives any re-registration
+			std::function<Task<std::shared_ptr<TObject>>()> alloc;
+
+			// declared allocators take precedence, as they do in Get
+			if (!IsStatic<TZone>::value)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				// decorators can't await, so a decorated zone gets its object through the decorated allocator, which blocks on the coroutine
+				int zone;
+				auto found = Resolve(TZone, zone) && m_decoration.find(TZone) == m_decoration.end() ? m_coAllocFunc.find(zone) : m_coAllocFunc.end();
+				if (found != m_coAllocFunc.end())
+				{
+					alloc = found->second;
+				}
+			}
+
+			if (!alloc)
+			{
+				co_return Allocate<TZone>(IsStatic<TZone>());
+			}
+
+			co_return co_await alloc();
+		}
+
+#endif
+	private:
+		friend class GlobalObject<TObject>;
+		friend class PooledObject<TObject>;
+
+		template <class TOther>
+		friend class Object;
+
+		template <int TZone>
+		friend struct AutoWire;
+
+		/// <summary>
+		/// Allocates with the calling thread's override for a zone, if it has one
+		/// </summary>
+		/// <returns>true if overridden</returns>
+		template <int TZone>
+		static bool Overridden(std::shared_ptr<TObject>& obj)
+		{
+			if (!Overrides::IsActive())
+			{
+				return false;
+			}
+
+			auto current = Override<TZone>::Current();
+			if (current == nullptr)
+			{
+				return false;
+			}
+
+			obj = current->m_alloc();
+			return true;
+		}
+
+		/// <summary>
+		/// Determines if <c>TObject</c> has an allocator declared at compile time for a zone, via <see cref="StaticAllocator"/>
+		/// </summary>
+		template <int TZone, class = void>
+		struct IsStatic : std::false_type
+		{
+		};
+
+		template <int TZone>
+		struct IsStatic<TZone, decltype(StaticAllocator<TObject, TZone>::Allocate(), void())> : std::true_type
+		{
+		};
+
+		/// <summary>
+		/// Allocates with the allocator declared at compile time
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Allocate(std::true_type)
+		{
+			return StaticAllocator<TObject, TZone>::Allocate();
+		}
+
+		/// <summary>
+		/// Allocates with the allocator registered at runtime, if any
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Allocate(std::false_type)
+		{
+			auto alloc = Load<TZone>();
+
+			// if we have a custom allocator use it
+			if (alloc.get() == nullptr)
+			{
+				return Default<TZone>(std::is_same<typename Implementation<TObject, TZone>::type, TObject>());
+			}
+
+			return (*alloc)();
+		}
+
+		/// <summary>
+		/// Gets the implementation bound at compile time, when no allocator is registered
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Default(std::false_type)
+		{
+			static_assert(std::is_convertible<typename Implementation<TObject, TZone>::type*, TObject*>::value, "Implementation must publicly derive from TObject");
+
+			return GetImplementation<TZone>();
+		}
+
+		/// <summary>
+		/// Constructs <c>TObject</c> itself, when no allocator is registered
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Default(std::true_type)
+		{
+			return Default<TZone>(std::true_type(), std::integral_constant<bool, WiredArity<TZone>::Found>());
+		}
+
+		template <int TZone>
+		static std::shared_ptr<TObject> Default(std::true_type, std::true_type)
+		{
+			return Build<TZone>(std::integral_constant<bool, (WiredArity<TZone>::Arity > 0)>());
+		}
+
+		template <int TZone>
+		static std::shared_ptr<TObject> Default(std::true_type, std::false_type)
+		{
+			Unresolved<TZone>();
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Throws for a <c>TObject</c> that has no allocator registered, and no ctor that can be called without one. Checked when
+		/// getting rather than when compiling, since allocators are registered at runtime
+		/// </summary>
+		/// <remarks>
+		/// Non-public ctors are found by adding <c>friend Object&lt;TObject&gt;</c>. To check at compile time instead, specialize
+		/// <c>StaticAllocator</c> or <c>Implementation</c>
+		/// </remarks>
+		/// <exception cref="std::logic_error">Always</exception>
+		template <int TZone>
+		static void Unresolved()
+		{
+			throw std::logic_error(std::string("no allocator is registered for ") + typeid(TObject).name() + " zone " + std::to_string(TZone) +
+				", and it has no public default ctor or ctor taking only std::shared_ptr dependencies");
+		}
+
+		/// <summary>
+		/// The most dependencies an auto-wired ctor may take
+		/// </summary>
+		static const size_t MaxWiredArity = 8;
+
+		/// <summary>
+		/// One auto-wired argument per index
+		/// </summary>
+		template <int TZone, size_t TIndex>
+		using Wire = AutoWire<TZone>;
+
+		/// <summary>
+		/// Determines, at compile time, if <c>TObject</c> can be constructed from one dependency per index. Checked from here so
+		/// that ctors made accessible by <c>friend Object&lt;TObject&gt;</c> count
+		/// </summary>
+		template <int TZone, size_t... TIndices>
+		static auto CanWire(std::index_sequence<TIndices...>, int) -> decltype(new TObject(Wire<TZone, TIndices>()...), std::true_type());
+
+		template <int TZone, class TIndices>
+		static std::false_type CanWire(TIndices, long);
+
+		/// <summary>
+		/// Finds, at compile time, the fewest dependencies <c>TObject</c> can be constructed from
+		/// </summary>
+		template <int TZone, size_t TArity = 0, bool TWirable = decltype(CanWire<TZone>(std::make_index_sequence<TArity>(), 0))::value>
+		struct WiredArity : WiredArity<TZone, TArity + 1>
+		{
+		};
+
+		template <int TZone, size_t TArity>
+		struct WiredArity<TZone, TArity, true>
+		{
+			static const bool Found = true;
+			static const size_t Arity = TArity;
+		};
+
+		template <int TZone>
+		struct WiredArity<TZone, MaxWiredArity + 1, false>
+		{
+			static const bool Found = false;
+			static const size_t Arity = 0;
+		};
+
+		/// <summary>
+		/// Constructs <c>TObject</c>, getting each dependency from the same zone and recording how in a plan
+		/// </summary>
+		/// <param name="arguments">Set to the step that builds each dependency</param>
+		template <int TZone, size_t... TIndices>
+		static TObject* Construct(std::true_type, ConstructionPlan* plan, size_t* arguments, std::index_sequence<TIndices...>)
+		{
+			return new TObject(Wire<TZone, TIndices>(plan, &arguments[TIndices])...);
+		}
+
+		template <int TZone>
+		static TObject* Construct(std::true_type, ConstructionPlan*, size_t*, std::index_sequence<>)
+		{
+			return new TObject();
+		}
+
+		template <int TZone, class TIndices>
+		static TObject* Construct(std::false_type, ConstructionPlan*, size_t*, TIndices)
+		{
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Constructs <c>TObject</c> from the objects built by earlier steps of a plan
+		/// </summary>
+		template <int TZone, size_t... TIndices>
+		static std::shared_ptr<void> Replay(const std::shared_ptr<void>* built, const size_t* arguments)
+		{
+			return std::shared_ptr<TObject>(new TObject(ConstructionPlan::Argument(&built[arguments[TIndices]])...));
+		}
+
+		/// <summary>
+		/// Gets the step that constructs <c>TObject</c> from one argument per index
+		/// </summary>
+		template <int TZone, size_t... TIndices>
+		static ConstructionPlan::StepFuncType ReplayStep(std::index_sequence<TIndices...>)
+		{
+			return &Replay<TZone, TIndices...>;
+		}
+
+		/// <summary>
+		/// Builds a <c>TObject</c> that has no dependencies, so there is nothing to plan
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Build(std::false_type)
+		{
+			return std::shared_ptr<TObject>(Construct<TZone>(std::integral_constant<bool, WiredArity<TZone>::Found>(), nullptr, nullptr, std::index_sequence<>()));
+		}
+
+		/// <summary>
+		/// Builds a <c>TObject</c> by replaying the zone's plan, recording the plan first if there isn't a current one
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Build(std::true_type)
+		{
+			PlanPtr plan;
+
+			// copied out of the guard, since steps may block
+			{
+				Epoch::Guard guard;
+
+				auto published = PlanSlot<TZone>().load();
+				if (published != nullptr)
+				{
+					plan = *published;
+				}
+			}
+
+			// plans skip each dependency's get, so aren't replayed (or recorded) while overrides apply
+			auto overridden = Overrides::IsActive();
+			if (plan.get() != nullptr && plan->IsCurrent() && !overridden)
+			{
+				return std::static_pointer_cast<TObject>(plan->Run());
+			}
+
+			auto recording = std::make_shared<ConstructionPlan>();
+
+			size_t step;
+			auto obj = Record<TZone>(*recording, step);
+			if (overridden)
+			{
+				return obj;
+			}
+
+			// concurrent gets may still be replaying the previous plan
+			auto previous = PlanSlot<TZone>().exchange(new PlanPtr(std::move(recording)));
+			if (previous != nullptr)
+			{
+				Epoch::Retire(previous);
+			}
+
+			return obj;
+		}
+
+		/// <summary>
+		/// Gets a <c>TObject</c> while recording a plan, adding the steps that build it (and its auto-wired dependencies) to the plan
+		/// </summary>
+		/// <param name="step">Set to the step that builds the object</param>
+		/// <exception cref="std::logic_error">The object depends on itself</exception>
+		template <int TZone>
+		static std::shared_ptr<TObject> Record(ConstructionPlan& plan, size_t& step)
+		{
+			std::shared_ptr<TObject> obj;
+			if (Overridden<TZone>(obj))
+			{
+				step = plan.Add([](const std::shared_ptr<void>*, const size_t*) -> std::shared_ptr<void> { return Get<TZone>(); }, nullptr, 0);
+				return obj;
+			}
+
+			auto alloc = IsStatic<TZone>::value ? AllocFuncPtr() : Load<TZone>();
+
+			// allocators are opaque, so replaying calls them as usual
+			if (IsStatic<TZone>::value || alloc.get() != nullptr)
+			{
+				step = plan.Add([](const std::shared_ptr<void>*, const size_t*) -> std::shared_ptr<void> { return Get<TZone>(); }, nullptr, 0);
+				return alloc.get() == nullptr ? Allocate<TZone>(IsStatic<TZone>()) : (*alloc)();
+			}
+
+			return Record<TZone>(plan, step, std::is_same<typename Implementation<TObject, TZone>::type, TObject>());
+		}
+
+		/// <summary>
+		/// Records the implementation bound at compile time, followed by a step that converts it to <c>TObject</c>
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Record(ConstructionPlan& plan, size_t& step, std::false_type)
+		{
+			typedef typename Implementation<TObject, TZone>::type ImplementationType;
+
+			size_t argument;
+			std::shared_ptr<TObject> obj = Object<ImplementationType>::template Record<TZone>(plan, argument);
+
+			// steps hold a pointer to the type they build, which may differ from a pointer to its base
+			step = plan.Add([](const std::shared_ptr<void>* built, const size_t* arguments) -> std::shared_ptr<void> {
+				return std::shared_ptr<TObject>(std::static_pointer_cast<ImplementationType>(built[arguments[0]]));
+			}, &argument, 1);
+
+			return obj;
+		}
+
+		/// <summary>
+		/// Records the steps that construct <c>TObject</c> itself
+		/// </summary>
+		template <int TZone>
+		static std::shared_ptr<TObject> Record(ConstructionPlan& plan, size_t& step, std::true_type)
+		{
+			return Record<TZone>(plan, step, std::true_type(), std::integral_constant<bool, WiredArity<TZone>::Found>());
+		}
+
+		template <int TZone>
+		static std::shared_ptr<TObject> Record(ConstructionPlan&, size_t&, std::true_type, std::false_type)
+		{
+			Unresolved<TZone>();
+			return nullptr;
+		}
+
+		template <int TZone>
+		static std::shared_ptr<TObject> Record(ConstructionPlan& plan, size_t& step, std::true_type, std::true_type)
+		{
+			ConstructionPlan::Scope scope(GlobalKey(typeid(TObject), TZone), false);
+
+			// dependencies add their steps first, so the plan stays in dependency order
+			size_t arguments[WiredArity<TZone>::Arity + 1];
+			std::shared_ptr<TObject> obj(Construct<TZone>(std::integral_constant<bool, WiredArity<TZone>::Found>(), &plan, arguments, std::make_index_sequence<WiredArity<TZone>::Arity>()));
+
+			step = plan.Add(ReplayStep<TZone>(std::make_index_sequence<WiredArity<TZone>::Arity>()), arguments, WiredArity<TZone>::Arity);
+			return obj;
+		}
+
+		/// <summary>
+		/// A recorded plan, shared with the gets that are replaying it so it may be replaced while in use
+		/// </summary>
+		typedef std::shared_ptr<const ConstructionPlan> PlanPtr;
+
+		/// <summary>
+		/// Gets where the plan for a zone is published
+		/// </summary>
+		template <int TZone>
+		static std::atomic<PlanPtr*>& PlanSlot()
+		{
+			static std::atomic<PlanPtr*> slot(nullptr);
+			return slot;
+		}
+
+		/// <summary>
+		/// The type of a reset function
+		/// </summary>
+		typedef std::function<void(TObject&)> ResetFuncType;
+
+		/// <summary>
+		/// A registered reset function, shared with the recycles that are calling it so it may be replaced while in use
+		/// </summary>
+		typedef std::shared_ptr<ResetFuncType> ResetFuncPtr;
+
+		/// <summary>
+		/// Gets where the reset function for a zone is published
+		/// </summary>
+		template <int TZone>
+		static std::atomic<ResetFuncPtr*>& ResetSlot()
+		{
+			static std::atomic<ResetFuncPtr*> slot(nullptr);
+			return slot;
+		}
+
+		/// <summary>
+		/// Determines if a zone has a reset function
+		/// </summary>
+		template <int TZone>
+		static bool HasReset()
+		{
+			return ResetSlot<TZone>().load() != nullptr;
+		}
+
+		/// <summary>
+		/// Resets an object in place with the zone's reset function, if it has one
+		/// </summary>
+		/// <returns>true if the object was reset</returns>
+		template <int TZone>
+		static bool ResetInPlace(TObject& obj)
+		{
+			ResetFuncPtr reset;
+
+			{
+				// copied out of the guard, since reset functions are user code
+				Epoch::Guard guard;
+
+				auto published = ResetSlot<TZone>().load();
+				if (published == nullptr)
+				{
+					return false;
+				}
+
+				reset = *published;
+			}
+
+			(*reset)(obj);
+			return true;
+		}
+
+		/// <summary>
+		/// The type of an allocator function
+		/// </summary>
+		typedef std::function<std::shared_ptr<TObject>()> AllocFuncType;
+
+		/// <summary>
+		/// A registered allocator, shared with the gets that are calling it so it may be replaced while in use
+		/// </summary>
+		typedef std::shared_ptr<const AllocFuncType> AllocFuncPtr;
+
+		/// <summary>
+		/// Where the resolved allocator for a zone is published, so gets can find it without taking <c>m_mutex</c>
+		/// </summary>
+		typedef std::atomic<AllocFuncPtr*> AllocSlotType;
+
+		/// <summary>
+		/// Gets the slot for a zone
+		/// </summary>
+		template <int TZone>
+		static AllocSlotType& ZoneSlot()
+		{
+			static AllocSlotType slot(nullptr);
+			return slot;
+		}
+
+		/// <summary>
+		/// Adds the slot for a zone to those kept resolved, must be called with <c>m_mutex</c> held
+		/// </summary>
+		template <int TZone>
+		static void Attach()
+		{
+			m_allocFunc.insert(std::make_pair(TZone, &ZoneSlot<TZone>()));
+			IsAttached<TZone>().store(true);
+		}
+
+		/// <summary>
+		/// Gets whether the slot for a zone has been attached
+		/// </summary>
+		template <int TZone>
+		static std::atomic<bool>& IsAttached()
+		{
+			static std::atomic<bool> attached(false);
+			return attached;
+		}
+
+		/// <summary>
+		/// Gets the allocator a zone resolves to, if any
+		/// </summary>
+		template <int TZone>
+		static AllocFuncPtr Load()
+		{
+			AllocFuncPtr alloc;
+
+			// copied out of the guard, since the allocator may block
+			{
+				Epoch::Guard guard;
+
+				auto registered = ZoneSlot<TZone>().load();
+				if (registered != nullptr)
+				{
+					alloc = *registered;
+				}
+			}
+
+			// zones may be registered by number (see Bindings) before anything attaches their slot, so misses attach it once
+			if (alloc.get() == nullptr && !IsAttached<TZone>().load())
+			{
+				Update([] { Attach<TZone>(); });
+				return Load<TZone>();
+			}
+
+			return alloc;
+		}
+
+		/// <summary>
+		/// Follows the fallbacks from a zone to the first zone with an allocator registered, must be called with <c>m_mutex</c> held
+		/// </summary>
+		/// <param name="resolved">Set to the zone whose allocator applies</param>
+		/// <returns>true if an allocator applies</returns>
+		static bool Resolve(int zone, int& resolved)
+		{
+			// fallbacks never form a cycle, so this ends
+			for (;;)
+			{
+				if (m_registered.find(zone) != m_registered.end())
+				{
+					resolved = zone;
+					return true;
+				}
+
+				auto fallback = m_fallback.find(zone);
+				if (fallback == m_fallback.end())
+				{
+					return false;
+				}
+
+				zone = fallback->second;
+			}
+		}
+
+		/// <summary>
+		/// Changes the registrations, and re-publishes the allocators that now resolve differently
+		/// </summary>
+		/// <param name="change">Function that changes the registrations, called with <c>m_mutex</c> held</param>
+		static void Update(const std::function<void()>& change)
+		{
+			std::vector<AllocFuncPtr*> previous;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				change();
+
+				for (auto& slot : m_allocFunc)
+				{
+					int zone;
+					auto resolved = Resolve(slot.first, zone) ? m_registered[zone] : AllocFuncPtr();
+
+					auto decoration = m_decoration.find(slot.first);
+					if (decoration != m_decoration.end())
+					{
+						resolved = Compose(resolved.get() != nullptr ? resolved : decoration->second.Default, decoration->second.Decorators);
+					}
+
+					auto current = slot.second->load();
+					if ((current == nullptr ? nullptr : current->get()) != resolved.get())
+					{
+						previous.push_back(slot.second->exchange(resolved.get() == nullptr ? nullptr : new AllocFuncPtr(resolved)));
+					}
+				}
+			}
+
+			// plans that auto-wired this type may now need to call an allocator, or stop calling one
+			ConstructionPlan::Invalidate();
+
+			// concurrent gets may still be reading the previous allocators
+			for (auto alloc : previous)
+			{
+				Epoch::Retire(alloc);
+			}
+		}
+
+		/// <summary>
+		/// The allocators added to a zone, which are never changed once published
+		/// </summary>
+		typedef std::vector<AllocFuncType> AllocListType;
+
+		/// <summary>
+		/// A published list, shared with the gets that are calling it so it may be replaced while in use
+		/// </summary>
+		typedef std::shared_ptr<const AllocListType> AllocListPtr;
+
+		/// <summary>
+		/// Where the list for a zone is published
+		/// </summary>
+		typedef std::atomic<AllocListPtr*> AllocListSlotType;
+
+		/// <summary>
+		/// Gets the list slot for a zone
+		/// </summary>
+		template <int TZone>
+		static AllocListSlotType& ListSlot()
+		{
+			static AllocListSlotType slot(nullptr);
+			return slot;
+		}
+
+		/// <summary>
+		/// Empties the lists of the zones that match
+		/// </summary>
+		/// <param name="match">Function that determines if a zone's list should be emptied, called with <c>m_mutex</c> held</param>
+		static void ClearLists(const std::function<bool(int)>& match)
+		{
+			std::vector<AllocListPtr*> previous;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				for (auto& slot : m_allocList)
+				{
+					if (match(slot.first))
+					{
+						auto list = slot.second->exchange(nullptr);
+						if (list != nullptr)
+						{
+							previous.push_back(list);
+						}
+					}
+				}
+			}
+
+			for (auto list : previous)
+			{
+				Epoch::Retire(list);
+			}
+		}
+
+		/// <summary>
+		/// The type of the list slot map
+		/// </summary>
+		typedef std::map<int, AllocListSlotType*> AllocListMapType;
+
+		/// <summary>
+		/// The list slots of the zones that have had allocators added, which are never removed
+		/// </summary>
+		static AllocListMapType m_allocList;
+
+		/// <summary>
+		/// Determines if <c>TObject</c> can be gotten for a zone without an allocator
+		/// </summary>
+		template <int TZone>
+		struct CanDefault : std::integral_constant<bool, !std::is_same<typename Implementation<TObject, TZone>::type, TObject>::value || WiredArity<TZone>::Found>
+		{
+		};
+
+		/// <summary>
+		/// Gets a function that gets <c>TObject</c> as if no allocator were registered, for decorators to wrap
+		/// </summary>
+		template <int TZone>
+		static AllocFuncPtr DefaultAlloc(std::true_type)
+		{
+			return std::make_shared<const AllocFuncType>([] { return Default<TZone>(std::is_same<typename Implementation<TObject, TZone>::type, TObject>()); });
+		}
+
+		template <int TZone>
+		static AllocFuncPtr DefaultAlloc(std::false_type)
+		{
+			return nullptr;
+		}
+
+		/// <summary>
+		/// Calls decorators known at compile time, each wrapping those before it
+		/// </summary>
+		template <class TNext>
+		static std::shared_ptr<TObject> Fuse(const TNext& next, std::tuple<>*)
+		{
+			return next();
+		}
+
+		template <class TNext, class TDecorator, class... TRest>
+		static std::shared_ptr<TObject> Fuse(const TNext& next, std::tuple<TDecorator, TRest...>*)
+		{
+			auto decorated = [&next] { return TDecorator()(next); };
+			return Fuse(decorated, static_cast<std::tuple<TRest...>*>(nullptr));
+		}
+
+		/// <summary>
+		/// Composes decorators around an allocator into a single function
+		/// </summary>
+		/// <returns>The function, or null if there is nothing to decorate</returns>
+		static AllocFuncPtr Compose(const AllocFuncPtr& alloc, const std::vector<std::function<std::shared_ptr<TObject>(const Next&)>>& decorators)
+		{
+			if (alloc.get() == nullptr || decorators.empty())
+			{
+				return alloc;
+			}
+
+			// outermost first, so calling the chain walks forward through contiguous storage
+			auto chain = std::make_shared<const std::vector<std::function<std::shared_ptr<TObject>(const Next&)>>>(decorators.rbegin(), decorators.rend());
+
+			return std::make_shared<const AllocFuncType>([alloc, chain] {
+				return Next(chain->data(), chain->data() + chain->size(), alloc.get())();
+			});
+		}
+
+		/// <summary>
+		/// The decorators of a zone, along with what they wrap when no allocator is registered
+		/// </summary>
+		struct Decoration
+		{
+			AllocFuncPtr Default;
+			std::vector<std::function<std::shared_ptr<TObject>(const Next&)>> Decorators;
+		};
+
+		/// <summary>
+		/// The type of the decoration map
+		/// </summary>
+		typedef std::map<int, Decoration> DecorationMapType;
+
+		/// <summary>
+		/// The decorators of each zone
+		/// </summary>
+		static DecorationMapType m_decoration;
+
+		/// <summary>
+		/// The type of the allocator slot map
+		/// </summary>
+		typedef std::map<int, AllocSlotType*> AllocFuncMapType;
+
+		/// <summary>
+		/// The type of the registered allocator map
+		/// </summary>
+		typedef std::map<int, AllocFuncPtr> RegisteredMapType;
+
+		/// <summary>
+		/// The type of the fallback map
+		/// </summary>
+		typedef std::map<int, int> FallbackMapType;
+
+		/// <summary>
+		/// The slots of the zones that have an allocator or fallback, which are never removed
+		/// </summary>
+		static AllocFuncMapType m_allocFunc;
+
+		/// <summary>
+		/// The allocators registered for each zone
+		/// </summary>
+		static RegisteredMapType m_registered;
+
+		/// <summary>
+		/// The zone each zone falls back to
+		/// </summary>
+		static FallbackMapType m_fallback;
+
+#ifdef CPPFACTORY_COROUTINES
+		/// <summary>
+		/// The type of the coroutine allocator function map
+		/// </summary>
+		typedef std::map<int, std::function<Task<std::shared_ptr<TObject>>()>> CoAllocFuncMapType;
+
+		/// <summary>
+		/// The coroutine allocator function map
+		/// </summary>
+		static CoAllocFuncMapType m_coAllocFunc;
+#endif
+
+		/// <summary>
+		/// Guards registration
+		/// </summary>
+		static std::mutex m_mutex;
+	};
+
+	template <class TObject>
+	typename Object<TObject>::AllocFuncMapType Object<TObject>::m_allocFunc = Object<TObject>::AllocFuncMapType();
+
+	template <class TObject>
+	typename Object<TObject>::RegisteredMapType Object<TObject>::m_registered = Object<TObject>::RegisteredMapType();
+
+	template <class TObject>
+	typename Object<TObject>::AllocListMapType Object<TObject>::m_allocList = Object<TObject>::AllocListMapType();
+
+	template <class TObject>
+	typename Object<TObject>::DecorationMapType Object<TObject>::m_decoration = Object<TObject>::DecorationMapType();
+
+	template <class TObject>
+	typename Object<TObject>::FallbackMapType Object<TObject>::m_fallback = Object<TObject>::FallbackMapType();
+
+#ifdef CPPFACTORY_COROUTINES
+	template <class TObject>
+	typename Object<TObject>::CoAllocFuncMapType Object<TObject>::m_coAllocFunc = Object<TObject>::CoAllocFuncMapType();
+#endif
+
+	template <class TObject>
+	std::mutex Object<TObject>::m_mutex;
+
+	template <int TZone>
+	template <class TDependency>
+	AutoWire<TZone>::operator std::shared_ptr<TDependency>() const
+	{
+		typedef typename std::remove_const<TDependency>::type DependencyType;
+
+		if (SharedDependency<DependencyType>::value)
+		{
+			auto obj = GlobalObject<DependencyType>::template Get<TZone>();
+
+			// globals are cached, so replaying gets them rather than planning how they are built
+			*m_step = m_plan->AddGlobal(GlobalObject<DependencyType>::template Key<TZone>(), [](const std::shared_ptr<void>*, const size_t*) -> std::shared_ptr<void> {
+				return GlobalObject<DependencyType>::template Get<TZone>();
+			});
+
+			return obj;
+		}
+
+		return Object<DependencyType>::template Record<TZone>(*m_plan, *m_step);
+	}
+
+	/// <summary>
+	/// Represents an <see cref="Object"/> that is recycled, rather than destroyed, when the last reference to it is released
+	/// </summary>
+	/// <remarks>
+	/// Each thread keeps a small cache (a "magazine") of released objects, so most <c>Get</c> and release calls touch no shared state.
+	/// Full magazines are exchanged through a lock-free depot, and a thread that runs dry steals from other threads before allocating
+	/// </remarks>
+	/// <param name="TObject">The type of object</param>
+	template <class TObject>
+	class PooledObject
+	{
+	public:
+		/// <summary>
+		/// The number of objects held by a single magazine
+		/// </summary>
+		static const size_t MagazineSize = 16;
+
+		/// <summary>
+		/// The number of full magazines the shared depot can hold
+		/// </summary>
+		static const size_t DepotSize = 32;
+
+		/// <summary>
+		/// Gets (recycling, if possible) a pooled object (optionally from a particular zone) for type <c>TObject</c>
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object, which returns to the pool once all references are released</returns>
+		/// <example>
+		/// PooledObject&lt;TObject&gt;::Get();
+		/// </example>
+		template <int TZone = 0>
+		static std::shared_ptr<TObject> Get()
+		{
+			std::shared_ptr<TObject> obj;
+
+			// overridden objects are never pooled, so they can't reach other threads
+			if (Object<TObject>::template Overridden<TZone>(obj))
+			{
+				return obj;
+			}
+
+			auto cache = LocalCache<TZone>();
+			if (cache != nullptr)
+			{
+				obj = cache->Acquire();
+			}
+
+			// nothing to recycle, so allocate as usual
+			if (obj.get() == nullptr)
+			{
+				obj = Object<TObject>::template Get<TZone>();
+			}
+
+			auto raw = obj.get();
+			return std::shared_ptr<TObject>(raw, Recycler<TZone>(std::move(obj)));
+		}
+
+		/// <summary>
+		/// Destroys the idle objects (across all zones) for type <c>TObject</c> held by the shared depot, and by threads for stealing
+		/// </summary>
+		/// <remarks>
+		/// Called by <see cref="MemoryPressure::Trim"/>. The few objects each thread keeps for itself are left alone
+		/// </remarks>
+		/// <example>
+		/// PooledObject&lt;TObject&gt;::Trim();
+		/// </example>
+		static void Trim()
+		{
+			auto& pools = Pools();
+			std::lock_guard<std::mutex> lock(pools.Mutex);
+
+			for (auto pool : pools.Items)
+			{
+				pool->Trim();
+			}
+		}
+
+	private:
+		class ThreadCache;
+
+		/// <summary>
+		/// A fixed size stack of recycled objects
+		/// </summary>
+		struct Magazine
+		{
+			std::array<std::shared_ptr<TObject>, MagazineSize> Items;
+			size_t Count = 0;
+		};
+
+		/// <summary>
+		/// The shared state of a pool for a single zone
+		/// </summary>
+		class Pool
+		{
+		public:
+			Pool()
+			{
+				for (auto& slot : m_depot)
+				{
+					slot.store(nullptr, std::memory_order_relaxed);
+				}
+
+				static const bool tracked = (MemoryPressure::Add([] { PooledObject::Trim(); }), true);
+				(void)tracked;
+
+				auto& pools = Pools();
+				std::lock_guard<std::mutex> lock(pools.Mutex);
+				pools.Items.push_back(this);
+			}
+
+			~Pool()
+			{
+				{
+					auto& pools = Pools();
+					std::lock_guard<std::mutex> lock(pools.Mutex);
+					pools.Items.erase(std::remove(pools.Items.begin(), pools.Items.end(), this), pools.Items.end());
+				}
+
+				for (auto& slot : m_depot)
+				{
+					delete slot.exchange(nullptr);
+				}
+			}
+
+			/// <summary>
+			/// Destroys the magazines in the depot, and those threads have published for stealing
+			/// </summary>
+			void Trim()
+			{
+				std::vector<Magazine*> idle;
+
+				for (auto& slot : m_depot)
+				{
+					idle.push_back(slot.exchange(nullptr, std::memory_order_acq_rel));
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_cachesMutex);
+
+					for (auto cache : m_caches)
+					{
+						idle.push_back(cache->m_full.exchange(nullptr, std::memory_order_acq_rel));
+					}
+				}
+
+				// destroy without holding the lock, in case destructors use pooled objects
+				for (auto magazine : idle)
+				{
+					delete magazine;
+				}
+			}
+
+			/// <summary>
+			/// Stores a full magazine in the depot, taking ownership of it
+			/// </summary>
+			void Deposit(Magazine* magazine)
+			{
+				for (auto& slot : m_depot)
+				{
+					Magazine* expected = nullptr;
+					if (slot.load(std::memory_order_relaxed) == nullptr &&
+						slot.compare_exchange_strong(expected, magazine, std::memory_order_acq_rel))
+					{
+						return;
+					}
+				}
+
+				// the depot is full, so these objects are surplus
+				delete magazine;
+			}
+
+			/// <summary>
+			/// Takes a full magazine from the depot, if there is one
+			/// </summary>
+			Magazine* Withdraw()
+			{
+				for (auto& slot : m_depot)
+				{
+					if (slot.load(std::memory_order_relaxed) != nullptr)
+					{
+						auto magazine = slot.exchange(nullptr, std::memory_order_acq_rel);
+						if (magazine != nullptr)
+						{
+							return magazine;
+						}
+					}
+				}
+
+				return nullptr;
+			}
+
+			/// <summary>
+			/// Takes a full magazine from another thread's cache, if there is one
+			/// </summary>
+			Magazine* Steal(ThreadCache* thief)
+			{
+				std::lock_guard<std::mutex> lock(m_cachesMutex);
+
+				for (auto cache : m_caches)
+				{
+					if (cache != thief)
+					{
+						auto magazine = cache->m_full.exchange(nullptr, std::memory_order_acq_rel);
+						if (magazine != nullptr)
+						{
+							return magazine;
+						}
+					}
+				}
+
+				return nullptr;
+			}
+
+			void Attach(ThreadCache* cache)
+			{
+				std::lock_guard<std::mutex> lock(m_cachesMutex);
+				m_caches.push_back(cache);
+			}
+
+			void Detach(ThreadCache* cache)
+			{
+				std::lock_guard<std::mutex> lock(m_cachesMutex);
+				m_caches.erase(std::remove(m_caches.begin(), m_caches.end(), cache), m_caches.end());
+			}
+
+		private:
+			/// <summary>
+			/// Full magazines that are not owned by any thread
+			/// </summary>
+			std::array<std::atomic<Magazine*>, DepotSize> m_depot;
+
+			/// <summary>
+			/// Guards <c>m_caches</c>, which is only touched on thread start, thread exit and steals
+			/// </summary>
+			std::mutex m_cachesMutex;
+
+			/// <summary>
+			/// The per-thread caches that may be stolen from
+			/// </summary>
+			std::vector<ThreadCache*> m_caches;
+		};
+
+		/// <summary>
+		/// The per-thread state of a pool for a single zone
+		/// </summary>
+		class ThreadCache
+		{
+		public:
+			ThreadCache(Pool& pool, bool& destroyed) :
+				m_pool(pool),
+				m_destroyed(destroyed),
+				m_loaded(new Magazine()),
+				m_spare(nullptr),
+				m_full(nullptr)
+			{
+				m_pool.Attach(this);
+			}
+
+			~ThreadCache()
+			{
+				m_pool.Detach(this);
+				m_destroyed = true;
+
+				// hand anything we're holding back to the depot for other threads
+				auto full = m_full.exchange(nullptr, std::memory_order_acq_rel);
+				if (full != nullptr)
+				{
+					m_pool.Deposit(full);
+				}
+
+				if (m_loaded->Count > 0)
+				{
+					m_pool.Deposit(m_loaded);
+				}
+				else
+				{
+					delete m_loaded;
+				}
+
+				delete m_spare;
+			}
+
+			std::shared_ptr<TObject> Acquire()
+			{
+				if (m_loaded->Count == 0)
+				{
+					auto magazine = m_full.exchange(nullptr, std::memory_order_acq_rel);
+					if (magazine == nullptr)
+					{
+						magazine = m_pool.Withdraw();
+					}
+					if (magazine == nullptr)
+					{
+						magazine = m_pool.Steal(this);
+					}
+					if (magazine == nullptr)
+					{
+						return nullptr;
+					}
+
+					Load(magazine);
+				}
+
+				return std::move(m_loaded->Items[--m_loaded->Count]);
+			}
+
+			void Release(std::shared_ptr<TObject>&& obj)
+			{
+				if (m_loaded->Count == MagazineSize)
+				{
+					// publish the full magazine where other threads can steal it
+					auto previous = m_full.exchange(m_loaded, std::memory_order_acq_rel);
+					if (previous != nullptr)
+					{
+						m_pool.Deposit(previous);
+					}
+
+					m_loaded = m_spare != nullptr ? m_spare : new Magazine();
+					m_spare = nullptr;
+				}
+
+				m_loaded->Items[m_loaded->Count++] = std::move(obj);
+			}
+
+		private:
+			friend class Pool;
+
+			/// <summary>
+			/// Replaces the (empty) loaded magazine, keeping it around for reuse
+			/// </summary>
+			void Load(Magazine* magazine)
+			{
+				if (m_spare == nullptr)
+				{
+					m_spare = m_loaded;
+				}
+				else
+				{
+					delete m_loaded;
+				}
+
+				m_loaded = magazine;
+			}
+
+			Pool& m_pool;
+			bool& m_destroyed;
+
+			/// <summary>
+			/// The magazine this thread pops from and pushes to, only touched by the owning thread
+			/// </summary>
+			Magazine* m_loaded;
+
+			/// <summary>
+			/// An empty magazine kept for reuse, only touched by the owning thread
+			/// </summary>
+			Magazine* m_spare;
+
+			/// <summary>
+			/// A full magazine that the owning thread or a stealing thread may take
+			/// </summary>
+			std::atomic<Magazine*> m_full;
+		};
+
+		/// <summary>
+		/// Deleter that returns an object to the pool, rather than destroying it
+		/// </summary>
+		template <int TZone>
+		class Recycler
+		{
+		public:
+			Recycler(std::shared_ptr<TObject>&& obj) : m_obj(std::move(obj))
+			{
+			}
+
+			void operator()(TObject*)
+			{
+				auto cache = LocalCache<TZone>();
+
+				// the thread is exiting, so there's nowhere to return the object to
+				if (cache == nullptr)
+				{
+					m_obj.reset();
+					return;
+				}
+
+				try
+				{
+					Object<TObject>::template ResetInPlace<TZone>(*m_obj);
+				}
+				catch (...)
+				{
+					// the object may be half reset, so it can't be reused
+					m_obj.reset();
+					return;
+				}
+
+				cache->Release(std::move(m_obj));
+			}
+
+		private:
+			std::shared_ptr<TObject> m_obj;
+		};
+
+		/// <summary>
+		/// The pools (one per zone) for type <c>TObject</c>, so they can be trimmed together
+		/// </summary>
+		struct PoolList
+		{
+			std::mutex Mutex;
+			std::vector<Pool*> Items;
+		};
+
+		static PoolList& Pools()
+		{
+			static PoolList pools;
+			return pools;
+		}
+
+		/// <summary>
+		/// Gets the shared pool for a zone
+		/// </summary>
+		template <int TZone>
+		static Pool& SharedPool()
+		{
+			static Pool pool;
+			return pool;
+		}
+
+		/// <summary>
+		/// Gets the calling thread's cache for a zone, or <c>nullptr</c> if the thread is exiting
+		/// </summary>
+		template <int TZone>
+		static ThreadCache* LocalCache()
+		{
+			// trivially destructible, so this remains readable while the thread tears down
+			static thread_local bool destroyed = false;
+			if (destroyed)
+			{
+				return nullptr;
+			}
+
+			static thread_local ThreadCache cache(SharedPool<TZone>(), destroyed);
+			return &cache;
+		}
+	};
+
+	/// <summary>
+	/// Represents a child of the process-wide <see cref="Object"/> and <see cref="GlobalObject"/> state (or of another scope), with
+	/// its own registrations and cached objects, such as for a single request
+	/// </summary>
+	/// <remarks>
+	/// Safe to use from multiple threads. Creating a scope is a single allocation, and nothing is copied from its parent. Gets check
+	/// each scope, from the child up, and fall through to the process-wide state if none of them has a registration. Copies share the same scope
+	/// </remarks>
+	/// <example>
+	/// Scope request = Scope().CreateChild();
+	/// request.RegisterAllocator&lt;TObject&gt;([](const Scope&amp;) { return std::make_shared&lt;TObject&gt;(); });
+	/// auto obj = request.GetGlobal&lt;TObject&gt;();
+	/// </example>
+	class Scope
+	{
+	public:
+		/// <summary>
+		/// Creates a scope whose parent is the process-wide state
+		/// </summary>
+		Scope() : m_node(std::make_shared<Node>(nullptr))
+		{
+		}
+
+		/// <summary>
+		/// Creates a scope whose parent is this scope
+		/// </summary>
+		/// <returns>The child</returns>
+		Scope CreateChild() const
+		{
+			return Scope(std::make_shared<Node>(m_node));
+		}
+
+		/// <summary>
+		/// Registers logic capable of allocating an object of type <c>TObject</c> in this scope and its children
+		/// </summary>
+		/// <param name="TZone">The zone to register for</param>
+		/// <param name="alloc">Function that allocates an object, given the scope it is allocated for</param>
+		/// <example>
+		/// scope.RegisterAllocator&lt;TObject&gt;([](const Scope&amp; scope) { return std::make_shared&lt;TObject&gt;(); });
+		/// </example>
+		template <class TObject, int TZone = 0>
+		void RegisterAllocator(const std::function<std::shared_ptr<TObject>(const Scope&)>& alloc)
+		{
+			auto func = std::make_shared<const std::function<std::shared_ptr<TObject>(const Scope&)>>(alloc);
+			m_node->Write(typeid(TObject), TZone, [&](Entry& entry) { entry.Alloc = func; });
+		}
+
+		/// <summary>
+		/// Caches an object of type <c>TObject</c> in this scope, which <see cref="GetGlobal"/> returns for this scope and its children
+		/// </summary>
+		/// <param name="TZone">The zone to cache in</param>
+		/// <param name="obj">The object</param>
+		template <class TObject, int TZone = 0>
+		void Set(const std::shared_ptr<TObject>& obj)
+		{
+			m_node->Write(typeid(TObject), TZone, [&](Entry& entry) { entry.Instance = obj; });
+		}
+
+		/// <summary>
+		/// Allocates an object (optionally from a particular zone) for type <c>TObject</c>, with the allocator registered in the
+		/// nearest scope, or from <see cref="Object"/> if no scope has one
+		/// </summary>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		template <class TObject, int TZone = 0>
+		std::shared_ptr<TObject> Get() const
+		{
+			std::shared_ptr<const void> alloc;
+
+			for (auto node = m_node.get(); node != nullptr; node = node->Parent.get())
+			{
+				if (node->Find(typeid(TObject), TZone, nullptr, &alloc))
+				{
+					return (*std::static_pointer_cast<const std::function<std::shared_ptr<TObject>(const Scope&)>>(alloc))(*this);
+				}
+			}
+
+			return Object<TObject>::template Get<TZone>();
+		}
+
+		/// <summary>
+		/// Gets the object (optionally from a particular zone) for type <c>TObject</c> cached in the nearest scope. If that scope
+		/// has an allocator registered rather than an object, the object is allocated and cached there. If no scope has either,
+		/// gets from <see cref="GlobalObject"/>
+		/// </summary>
+		/// <remarks>
+		/// If two threads allocate the same object at once, both allocations run and the first to finish is kept
+		/// </remarks>
+		/// <param name="TZone">The zone to get from</param>
+		/// <returns>The object</returns>
+		template <class TObject, int TZone = 0>
+		std::shared_ptr<TObject> GetGlobal() const
+		{
+			std::shared_ptr<void> obj;
+			std::shared_ptr<const void> alloc;
+
+			for (auto node = m_node; node.get() != nullptr; node = node->Parent)
+			{
+				if (node->Find(typeid(TObject), TZone, &obj, &alloc))
+				{
+					if (obj.get() == nullptr)
+					{
+						// allocated for the scope it is cached in, which may be a parent of this one
+						std::shared_ptr<TObject> allocated = (*std::static_pointer_cast<const std::function<std::shared_ptr<TObject>(const Scope&)>>(alloc))(Scope(node));
+						node->Write(typeid(TObject), TZone, [&](Entry& entry) {
+							if (entry.Instance.get() == nullptr)
+							{
+								entry.Instance = allocated;
+							}
+
+							obj = entry.Instance;
+						});
+					}
+
+					return std::static_pointer_cast<TObject>(obj);
+				}
+			}
+
+			return GlobalObject<TObject>::template Get<TZone>();
+		}
+
+	private:
+		/// <summary>
+		/// What a scope has for a particular type and zone
+		/// </summary>
+		struct Entry
+		{
+			std::type_index Type;
+			int Zone;
+			std::shared_ptr<void> Instance;
+			std::shared_ptr<const void> Alloc;
+		};
+
+		/// <summary>
+		/// The entries of a scope, which are never changed once published
+		/// </summary>
+		typedef std::vector<Entry> Overlay;
+
+		/// <summary>
+		/// The state shared by copies of a scope
+		/// </summary>
+		class Node
+		{
+		public:
+			explicit Node(const std::shared_ptr<Node>& parent) : Parent(parent), m_overlay(nullptr)
+			{
+			}
+
+			~Node()
+			{
+				// nobody can be reading a scope that is being destroyed
+				delete m_overlay.load();
+			}
+
+			Node(const Node&) = delete;
+			Node& operator=(const Node&) = delete;
+
+			/// <summary>
+			/// Finds the entry for a type and zone, if it has an object or allocator
+			/// </summary>
+			/// <param name="obj">Set to the cached object, if not null</param>
+			/// <param name="alloc">Set to the registered allocator</param>
+			/// <returns>true if found</returns>
+			bool Find(const std::type_index& type, int zone, std::shared_ptr<void>* obj, std::shared_ptr<const void>* alloc) const
+			{
+				Epoch::Guard guard;
+
+				// most scopes never change, so the common case is a single load
+				auto overlay = m_overlay.load();
+				if (overlay == nullptr)
+				{
+					return false;
+				}
+
+				for (auto& entry : *overlay)
+				{
+					if (entry.Type == type && entry.Zone == zone && ((obj != nullptr && entry.Instance.get() != nullptr) || entry.Alloc.get() != nullptr))
+					{
+						if (obj != nullptr)
+						{
+							*obj = entry.Instance;
+						}
+
+						*alloc = entry.Alloc;
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			/// <summary>
+			/// Publishes a copy of the entries with the entry for a type and zone changed
+			/// </summary>
+			/// <param name="change">Function that changes the entry, called with <c>m_mutex</c> held</param>
+			void Write(const std::type_index& type, int zone, const std::function<void(Entry&)>& change)
+			{
+				std::vector<std::unique_ptr<Overlay>>* batch = nullptr;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+
+					auto current = m_overlay.load();
+					auto overlay = current == nullptr ? new Overlay() : new Overlay(*current);
+
+					auto entry = std::find_if(overlay->begin(), overlay->end(), [&](const Entry& entry) { return entry.Type == type && entry.Zone == zone; });
+					if (entry == overlay->end())
+					{
+						overlay->push_back(Entry{ type, zone, nullptr, nullptr });
+						entry = overlay->end() - 1;
+					}
+
+					change(*entry);
+					auto previous = m_overlay.exchange(overlay);
+
+					// concurrent gets may still be reading the previous entries, so they are kept until the scope is destroyed,
+					// and only handed to the epoch in batches for scopes that are written to often
+					if (previous != nullptr)
+					{
+						m_retired.emplace_back(previous);
+
+						if (m_retired.size() >= RetireBatch)
+						{
+							batch = new std::vector<std::unique_ptr<Overlay>>(std::move(m_retired));
+							m_retired.clear();
+						}
+					}
+				}
+
+				if (batch != nullptr)
+				{
+					Epoch::Retire(batch);
+				}
+			}
+
+			const std::shared_ptr<Node> Parent;
+
+		private:
+			/// <summary>
+			/// The most replaced entries a scope keeps before retiring them together
+			/// </summary>
+			static const size_t RetireBatch = 16;
+
+			std::atomic<Overlay*> m_overlay;
+			std::vector<std::unique_ptr<Overlay>> m_retired;
+			std::mutex m_mutex;
+		};
+
+		explicit Scope(const std::shared_ptr<Node>& node) : m_node(node)
+		{
+		}
+
+		std::shared_ptr<Node> m_node;
+	};
+
+	/// <summary>
+	/// Represents a traditional factory capable of creating allocating objects
+	/// </summary>
+	/// <param name="TObject">The type of object</param>
+	/// <param name="Args">The ctor argument types for the object constructor</param>
+	template <class TObject, class ...Args>
+	class Factory
+	{
+	public:
+		/// <summary>
+		/// Allocates an instance of type <see cref="TObject"/>
+		/// </summary>
+		/// <remarks>
+		/// If <see cref="TObject"/> is abstract, this throws std::logic_error unless overridden; use <see cref="Create"/> instead
+		/// </remarks>
+		virtual std::shared_ptr<TObject> Allocate(Args&&... args)
+		{
+			return Make(std::is_constructible<TObject, Args&...>(), args...);
+		}
+
+		/// <summary>
+		/// Registers type <see cref="TDerived"/> to be created for a key
+		/// </summary>
+		/// <param name="key">The key, a non-negative integer or enum value</param>
+		/// <remarks>
+		/// Keys index a dense table, so they should be small and close together.
+		/// Registering is not synchronized with <see cref="Create"/>; register before sharing the factory.
+		/// Throws std::out_of_range if the key is negative.
+		/// </remarks>
+		template <class TDerived, class TKey>
+		void Register(TKey key)
+		{
+			static_assert(std::is_base_of<TObject, TDerived>::value, "TDerived must derive from TObject");
+			static_assert(std::is_constructible<TDerived, Args...>::value, "TDerived must be constructible from Args");
+
+			auto index = Index(key);
+			if (index >= m_createTable.size())
+			{
+				m_createTable.resize(index + 1, nullptr);
+			}
+
+			m_createTable[index] = &Construct<TDerived>;
+		}
+
+		/// <summary>
+		/// Removes the type registered for a key
+		/// </summary>
+		/// <param name="key">The key, an integer or enum value</param>
+		template <class TKey>
+		void Unregister(TKey key)
+		{
+			if (HasIndex(key) && Index(key) < m_createTable.size())
+			{
+				m_createTable[Index(key)] = nullptr;
+			}
+		}
+
+		/// <summary>
+		/// Determines if a type is registered for a key
+		/// </summary>
+		/// <param name="key">The key, an integer or enum value</param>
+		template <class TKey>
+		bool IsRegistered(TKey key) const
+		{
+			return HasIndex(key) && Index(key) < m_createTable.size() && m_createTable[Index(key)] != nullptr;
+		}
+
+		/// <summary>
+		/// Creates an instance of the type registered for a key
+		/// </summary>
+		/// <param name="key">The key, an integer or enum value</param>
+		/// <param name="args">The constructor arguments, converted to <see cref="Args"/> and forwarded to the registered type</param>
+		/// <remarks>
+		/// Dispatch is a bounds check and an indirect call through the table.
+		/// Throws std::out_of_range if no type is registered for the key.
+		/// </remarks>
+		template <class TKey, class ...TArgs>
+		std::shared_ptr<TObject> Create(TKey key, TArgs&&... args) const
+		{
+			auto index = Index(key);
+			if (index >= m_createTable.size() || m_createTable[index] == nullptr)
+			{
+				throw std::out_of_range("no type is registered for factory key " + std::to_string(static_cast<long long>(key)));
+			}
+
+			return m_createTable[index](std::forward<TArgs>(args)...);
+		}
+
+	private:
+		// arguments are taken as declared, so lvalues may be passed for arguments declared by value
+		typedef std::shared_ptr<TObject>(*CreateFuncPtr)(Args...);
+
+		static std::shared_ptr<TObject> Make(std::true_type, Args&... args)
+		{
+			return std::make_shared<TObject>(args...);
+		}
+
+		static std::shared_ptr<TObject> Make(std::false_type, Args&...)
+		{
+			throw std::logic_error("factory type can't be constructed from its arguments; register types and use Create");
+		}
+
+		template <class TDerived>
+		static std::shared_ptr<TObject> Construct(Args... args)
+		{
+			return std::make_shared<TDerived>(std::forward<Args>(args)...);
+		}
+
+		/// <summary>
+		/// Determines if a key has an index in the table, which negative keys don't
+		/// </summary>
+		template <class TKey>
+		static bool HasIndex(TKey key)
+		{
+			static_assert(std::is_integral<TKey>::value || std::is_enum<TKey>::value, "TKey must be an integer or enum");
+
+			typedef typename std::conditional<std::is_enum<TKey>::value, std::underlying_type<TKey>, std::common_type<TKey>>::type::type ValueType;
+			return !std::is_signed<ValueType>::value || static_cast<ValueType>(key) >= ValueType(0);
+		}
+
+		/// <summary>
+		/// Gets the index of a key in the table
+		/// </summary>
+		/// <exception cref="std::out_of_range">The key is negative</exception>
+		template <class TKey>
+		static size_t Index(TKey key)
+		{
+			if (!HasIndex(key))
+			{
+				throw std::out_of_range("factory keys may not be negative, got " + std::to_string(static_cast<long long>(key)));
+			}
+
+			return static_cast<size_t>(key);
+		}
+
+		std::vector<CreateFuncPtr> m_createTable;
 	};
 }